@@ -0,0 +1,83 @@
+/// @file bench-family.cpp
+///
+/// @brief Throughput of the copula family log-PDF, h-function, and CDF.
+///
+/// Compiled with `Rcpp::sourceCpp()` against the headers of the installed package, outside of \pkg{TMB}.
+
+// [[Rcpp::depends(RcppEigen)]]
+// [[Rcpp::depends(LocalCop)]]
+// [[Rcpp::plugins(cpp17)]]
+#ifndef LOCALCOP_NO_TMB
+#define LOCALCOP_NO_TMB
+#endif
+#include <RcppEigen.h>
+#include "LocalCop/family.hpp"
+#include <chrono>
+
+using namespace LocalCop;
+
+namespace {
+
+  /// Time `nrep` passes of a family function over all observations.
+  ///
+  /// The sum of the function values is returned along with the time, such that the compiler can't remove the loop.
+  struct BenchFamily {
+    typedef Rcpp::NumericVector result_type;
+    const double* u1;
+    const double* u2;
+    int n;
+    double theta;
+    double nu;
+    int fun;
+    int nrep;
+    template <template<class> class Family>
+    result_type operator()(FamilyTag<Family>) const {
+      typedef Family<double> Fam;
+      double sum = 0.0;
+      if(fun == 2 && !Fam::has_pfun) {
+        return Rcpp::NumericVector::create(NA_REAL, NA_REAL);
+      }
+      auto start = std::chrono::steady_clock::now();
+      for(int rep=0; rep<nrep; rep++) {
+        for(int ii=0; ii<n; ii++) {
+          switch(fun) {
+          case 0: sum += Fam::dfun(u1[ii], u2[ii], theta, nu, 1); break;
+          case 1: sum += Fam::hfun(u1[ii], u2[ii], theta, nu, 0); break;
+          default: sum += Fam::pfun(u1[ii], u2[ii], theta, nu, 0); break;
+          }
+        }
+      }
+      std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+      return Rcpp::NumericVector::create(elapsed.count(), sum);
+    }
+  };
+
+} // end namespace
+
+/// Time a copula family function.
+///
+/// @param[in] u1 Vector of first uniform variables.
+/// @param[in] u2 Vector of second uniform variables.
+/// @param[in] family Copula family.
+/// @param[in] theta Copula parameter.
+/// @param[in] nu Second copula parameter.
+/// @param[in] fun Which function to time: 0 for the log-PDF, 1 for the h-function, and 2 for the CDF.
+/// @param[in] nrep Number of passes over the data.
+///
+/// @return A vector with elements `time`, the elapsed time in seconds, and `sum`, the sum of the function values.  Both are `NA` if the CDF of the family isn't available.
+// [[Rcpp::export]]
+Rcpp::NumericVector bench_family(Rcpp::NumericVector u1,
+                                 Rcpp::NumericVector u2,
+                                 int family, double theta, double nu,
+                                 int fun, int nrep) {
+  if(!valid_family(family)) Rcpp::stop("Unsupported family.");
+  if(u2.size() != u1.size()) {
+    Rcpp::stop("u1 and u2 must have the same length.");
+  }
+  BenchFamily bench = {u1.begin(), u2.begin(), static_cast<int>(u1.size()),
+                       theta, nu, fun, nrep};
+  Rcpp::NumericVector ans = dispatch_family(family, bench);
+  ans.names() = Rcpp::CharacterVector::create("time", "sum");
+  return ans;
+}
@@ -0,0 +1,507 @@
+/// @file localcop.cpp
+///
+/// @brief Command line interface to the standalone local likelihood library.
+///
+/// Fits a conditional copula model to a dataset `(u1, u2, x)` without R, using the same compiled code as `CondiCopLocFit()` and `CondiCopSelect()` with `engine = "native"`, and converts datasets to memory-mapped column files (see `colfile.hpp`).  Run `localcop --help` for usage.
+
+#include "LocalCop/select.hpp"
+#include "LocalCop/colfile.hpp"
+#include "LocalCop/binned.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <cmath>
+
+using namespace LocalCop;
+
+namespace {
+
+  const char* usage =
+    "Usage: localcop fit|select [options] FILE\n"
+    "       localcop convert [options] INPUT OUTPUT\n"
+    "\n"
+    "Local likelihood estimation of a conditional copula model from the uniform\n"
+    "responses (u1, u2) and covariate x in FILE, which is either a CSV file with\n"
+    "columns u1, u2, x (in that order, or named in a header line), a binary\n"
+    "file of little-endian float64 records (u1, u2, x), or a column file created\n"
+    "by convert.  Column files are memory-mapped rather than read into memory.\n"
+    "Results are written to standard output in CSV format.\n"
+    "\n"
+    "Commands:\n"
+    "  fit       Fit the local likelihood at covariate values x0.\n"
+    "  select    Select the family and bandwidth by cross-validated likelihood.\n"
+    "  convert   Convert a CSV or binary file to a column file sorted by x,\n"
+    "            in chunks which are sorted on disk.\n"
+    "\n"
+    "Options:\n"
+    "  --family F      Copula family, or comma-separated families for select.\n"
+    "                  Default for select: 1,2,3,4,5.\n"
+    "  --nu V          Second parameter of the Student-t copula (family 2).\n"
+    "  --band H        Bandwidth, or comma-separated bandwidths for select.\n"
+    "  --nband N       Number of default bandwidths for select.  Default: 6.\n"
+    "  --band-type T   constant, or variable for bandwidths given as the fraction\n"
+    "                  of nearest neighbours of each x0.  Default: constant.\n"
+    "  --x0 A,B,...    Covariate values at which to fit the local likelihood.\n"
+    "  --nx N          Otherwise, N equally spaced values in range(x).  Default: 100.\n"
+    "  --degree D      Degree of the local polynomial: 0 or 1.  Default: 1.\n"
+    "  --kernel K      One of epa, gaus, beta, biquad, triang.  Default: epa.\n"
+    "  --eta A[,B]     Starting value of the local coefficients.  Default: 1,0.\n"
+    "  --xind N        Number of leave-one-out fits for select.  Default: 100.\n"
+    "  --cv-all        Validate at all observations rather than at xind only.\n"
+    "  --loo M         Leave-one-out method: refit or downdate.  Default: refit.\n"
+    "  --warm-start    Start each fit from the previous one.\n"
+    "  --threads N     Number of threads, or 0 for all cores.  Default: 1.\n"
+    "  --nbin NX[,NU]  For fit, maximize the binned local likelihood with NX bins\n"
+    "                  along x and NU x NU bins along (u1, u2), and report its\n"
+    "                  error against the exact local likelihood in columns\n"
+    "                  bin_nll and bin_eta.\n"
+    "  --format F      Input format: csv or bin.  Default: from the file extension.\n"
+    "  --utrans P      Cache the marginal transformations of a column file in\n"
+    "                  files P.<family>.lcc, which are reused if they exist and\n"
+    "                  were calculated from the same u1 and u2.\n"
+    "  --float32       For convert, store values as float32 instead of float64.\n"
+    "  --chunk N       For convert, rows sorted in memory.  Default: 4194304.\n"
+    "  --tmpdir D      For convert, directory of temporary files.\n"
+    "  --help          Print this message.\n";
+
+  /// Split a comma-separated list.
+  std::vector<std::string> split(const std::string& s, char sep = ',') {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while(std::getline(ss, item, sep)) out.push_back(item);
+    return out;
+  }
+
+  double to_double(const std::string& s) {
+    std::size_t pos;
+    double val = std::stod(s, &pos);
+    if(pos != s.size()) throw std::invalid_argument("invalid number: " + s);
+    return val;
+  }
+
+  int to_int(const std::string& s) {
+    std::size_t pos;
+    int val = std::stoi(s, &pos);
+    if(pos != s.size()) throw std::invalid_argument("invalid integer: " + s);
+    return val;
+  }
+
+  template <class T>
+  std::vector<T> to_vector(const std::string& s, T (*conv)(const std::string&)) {
+    std::vector<T> out;
+    for(const auto& item : split(s)) out.push_back(conv(item));
+    return out;
+  }
+
+  Kernel to_kernel(const std::string& s) {
+    static const std::map<std::string, Kernel> kernels = {
+      {"epa", Kernel::Epa}, {"gaus", Kernel::Gaus}, {"beta", Kernel::Beta},
+      {"biquad", Kernel::BiQuad}, {"triang", Kernel::TriAng}
+    };
+    auto it = kernels.find(s);
+    if(it == kernels.end()) throw std::invalid_argument("unknown kernel: " + s);
+    return it->second;
+  }
+
+  BandType to_band_type(const std::string& s) {
+    if(s == "constant") return BandType::Constant;
+    if(s == "variable") return BandType::Variable;
+    throw std::invalid_argument("unknown band type: " + s);
+  }
+
+  /// Callback on each row `(u1, u2, x)` of an input file.
+  using RowFun = std::function<void(double, double, double)>;
+
+  /// Dataset sorted by covariate, either in memory or in a column file.
+  struct Data {
+    VectorXd u1_, u2_, x_; // storage of data in memory
+    std::unique_ptr<ColFile> file; // column file, if any
+    const double* pu1;
+    const double* pu2;
+    const double* px;
+    int n;
+    Map<const VectorXd> u1() const {return Map<const VectorXd>(pu1, n);}
+    Map<const VectorXd> u2() const {return Map<const VectorXd>(pu2, n);}
+    Map<const VectorXd> x() const {return Map<const VectorXd>(px, n);}
+  };
+
+  /// Read a CSV file with columns `u1`, `u2`, `x`.
+  void read_csv(const std::string& file, const RowFun& row) {
+    std::ifstream in(file);
+    if(!in) throw std::runtime_error("cannot open file: " + file);
+    std::string line;
+    int col[3] = {0, 1, 2};
+    bool first = true;
+    while(std::getline(in, line)) {
+      if(!line.empty() && line.back() == '\r') line.pop_back();
+      if(line.empty()) continue;
+      std::vector<std::string> fields = split(line);
+      if(first) {
+        first = false;
+        char* end;
+        std::strtod(fields[0].c_str(), &end);
+        if(end == fields[0].c_str()) {
+          // header line: locate named columns, if any
+          const char* names[3] = {"u1", "u2", "x"};
+          for(int jj=0; jj<3; jj++) {
+            for(std::size_t kk=0; kk<fields.size(); kk++) {
+              std::string nm = fields[kk];
+              nm.erase(std::remove(nm.begin(), nm.end(), '"'), nm.end());
+              if(nm == names[jj]) col[jj] = kk;
+            }
+          }
+          continue;
+        }
+      }
+      int ncol = *std::max_element(col, col + 3) + 1;
+      if(static_cast<int>(fields.size()) < ncol) {
+        throw std::runtime_error("too few columns in line: " + line);
+      }
+      row(to_double(fields[col[0]]), to_double(fields[col[1]]),
+          to_double(fields[col[2]]));
+    }
+  }
+
+  /// Read a binary file of float64 records `(u1, u2, x)`.
+  void read_bin(const std::string& file, const RowFun& row) {
+    std::ifstream in(file, std::ios::binary);
+    if(!in) throw std::runtime_error("cannot open file: " + file);
+    double rec[3];
+    while(in.read(reinterpret_cast<char*>(rec), sizeof(rec))) {
+      row(rec[0], rec[1], rec[2]);
+    }
+    if(in.gcount() != 0) {
+      throw std::runtime_error("file size is not a multiple of 24 bytes: " + file);
+    }
+  }
+
+  /// Read each row of a CSV or binary file.
+  void read_rows(const std::string& file, std::string format,
+                 const RowFun& row) {
+    if(format.empty()) {
+      bool csv = file.size() >= 4 && file.substr(file.size() - 4) == ".csv";
+      format = csv ? "csv" : "bin";
+    }
+    if(format == "csv") {
+      read_csv(file, row);
+    } else if(format == "bin") {
+      read_bin(file, row);
+    } else {
+      throw std::invalid_argument("unknown format: " + format);
+    }
+  }
+
+  /// Column indices of `u1`, `u2`, `x` in a column file.
+  void colfile_index(const ColFile& file, int col[3]) {
+    const char* names[3] = {"u1", "u2", "x"};
+    for(int jj=0; jj<3; jj++) {
+      col[jj] = file.col_index(names[jj]);
+      if(col[jj] < 0) {
+        throw std::runtime_error(std::string("column file has no column ") +
+                                 names[jj]);
+      }
+    }
+  }
+
+  /// Read a dataset and sort it by covariate.
+  ///
+  /// Column files are already sorted, and `float64` column files are used without copying.
+  void read_data(const std::string& file, const std::string& format,
+                 Data& data) {
+    if(ColFile::is_colfile(file)) {
+      data.file.reset(new ColFile(file));
+      const ColFile& cf = *data.file;
+      int col[3];
+      colfile_index(cf, col);
+      if(!cf.sorted() || cf.header().sort_col != col[2]) {
+        throw std::runtime_error("column file is not sorted by x: " + file);
+      }
+      data.n = cf.nrow();
+      if(cf.is_double()) {
+        data.pu1 = cf.column(col[0]).data();
+        data.pu2 = cf.column(col[1]).data();
+        data.px = cf.column(col[2]).data();
+      } else {
+        data.u1_ = cf.column_copy(col[0]);
+        data.u2_ = cf.column_copy(col[1]);
+        data.x_ = cf.column_copy(col[2]);
+      }
+    } else {
+      std::vector<double> u1, u2, x;
+      read_rows(file, format, [&](double v1, double v2, double xi) {
+        u1.push_back(v1);
+        u2.push_back(v2);
+        x.push_back(xi);
+      });
+      int n = x.size();
+      std::vector<int> ix(n);
+      std::iota(ix.begin(), ix.end(), 0);
+      std::stable_sort(ix.begin(), ix.end(),
+                       [&x](int i, int j) { return x[i] < x[j]; });
+      data.u1_.resize(n);
+      data.u2_.resize(n);
+      data.x_.resize(n);
+      for(int ii=0; ii<n; ii++) {
+        data.u1_(ii) = u1[ix[ii]];
+        data.u2_(ii) = u2[ix[ii]];
+        data.x_(ii) = x[ix[ii]];
+      }
+      data.n = n;
+    }
+    if(data.n < 2) throw std::runtime_error("need at least two observations.");
+    if(data.x_.size() != 0) {
+      data.pu1 = data.u1_.data();
+      data.pu2 = data.u2_.data();
+      data.px = data.x_.data();
+    }
+  }
+
+  /// Convert a CSV or binary file to a column file sorted by `x`.
+  void convert(const std::string& input, const std::string& output,
+               const std::string& format, int dtype, std::size_t chunk,
+               const std::string& tmpdir) {
+    ColWriter writer(output, {"u1", "u2", "x"}, 2, dtype, chunk, tmpdir);
+    const int nblock = 4096;
+    MatrixXd block(nblock, 3);
+    int nb = 0;
+    read_rows(input, format, [&](double u1, double u2, double x) {
+      block(nb,0) = u1;
+      block(nb,1) = u2;
+      block(nb,2) = x;
+      if(++nb == nblock) {
+        writer.append(block);
+        nb = 0;
+      }
+    });
+    writer.append(block.topRows(nb));
+    writer.finish();
+  }
+
+  /// Marginal transformations of a dataset for a given family.
+  ///
+  /// If `prefix` is nonempty and the data are in a column file, the transformations are read from (or first written to) the column file `prefix.<family>.lcc`, and mapped without copying.  A cached file is only reused if its header matches `family`, `nu`, and the hash of the uniform responses in `data` (see `utrans_matches()`).  Otherwise they are calculated in memory and stored in `ut`.
+  Map<const MatrixXd, 0, OuterStride<> >
+  get_utrans(const Data& data, int family, double nu,
+             const std::string& prefix, MatrixXd& ut,
+             std::unique_ptr<ColFile>& cache) {
+    int nt = utrans_size(family);
+    if(prefix.empty() || !data.file) {
+      ut.resize(data.n, nt);
+      utrans(data.u1(), data.u2(), nu, family, ut);
+      return Map<const MatrixXd, 0, OuterStride<> >(ut.data(), data.n, nt,
+                                                    OuterStride<>(data.n));
+    }
+    std::string path = prefix + "." + std::to_string(family) + ".lcc";
+    int col[3];
+    colfile_index(*data.file, col);
+    cache.reset();
+    if(ColFile::is_colfile(path)) {
+      cache.reset(new ColFile(path));
+      if(!utrans_matches(*cache, *data.file, col[0], col[1], family, nu)) {
+        cache.reset();
+      }
+    }
+    if(!cache) {
+      write_utrans(*data.file, col[0], col[1], family, nu, path);
+      cache.reset(new ColFile(path));
+    }
+    return cache->matrix(0, nt);
+  }
+
+  /// Second copula parameter of a family.
+  double get_nu(int family, const std::map<std::string, std::string>& opt) {
+    if(!valid_family(family)) {
+      throw std::invalid_argument("unsupported family: " + std::to_string(family));
+    }
+    if(family != 2) return 0.0;
+    auto it = opt.find("nu");
+    if(it == opt.end()) {
+      throw std::invalid_argument("--nu is required for family 2.");
+    }
+    return to_double(it->second);
+  }
+
+  int run(int argc, char* argv[]) {
+    // parse arguments
+    std::map<std::string, std::string> opt;
+    std::vector<std::string> pos;
+    for(int ii=1; ii<argc; ii++) {
+      std::string arg = argv[ii];
+      if(arg == "--help" || arg == "-h") {
+        std::cout << usage;
+        return 0;
+      } else if(arg == "--cv-all" || arg == "--warm-start" ||
+                arg == "--float32") {
+        opt[arg.substr(2)] = "1";
+      } else if(arg.rfind("--", 0) == 0) {
+        if(ii + 1 >= argc) {
+          throw std::invalid_argument("missing value for " + arg);
+        }
+        opt[arg.substr(2)] = argv[++ii];
+      } else {
+        pos.push_back(arg);
+      }
+    }
+    auto get = [&opt](const std::string& name, const std::string& dflt) {
+      auto it = opt.find(name);
+      return it == opt.end() ? dflt : it->second;
+    };
+    if(pos.size() == 3 && pos[0] == "convert") {
+      int chunk = to_int(get("chunk", "4194304"));
+      if(chunk < 1) throw std::invalid_argument("chunk must be positive.");
+      convert(pos[1], pos[2], get("format", ""),
+              opt.count("float32") ? 4 : 8, chunk, get("tmpdir", ""));
+      return 0;
+    }
+    if(pos.size() != 2 || (pos[0] != "fit" && pos[0] != "select")) {
+      std::cerr << usage;
+      return 1;
+    }
+    Data data;
+    read_data(pos[1], get("format", ""), data);
+    int n = data.n;
+    Map<const VectorXd> x = data.x();
+    std::string prefix = get("utrans", "");
+    MatrixXd ut;
+    std::unique_ptr<ColFile> ut_cache;
+    int degree = to_int(get("degree", "1"));
+    if(degree != 0 && degree != 1) {
+      throw std::invalid_argument("degree must be 0 or 1.");
+    }
+    Kernel kernel = to_kernel(get("kernel", "epa"));
+    Vector2d eta = Vector2d::Zero();
+    std::vector<double> eta_in = to_vector<double>(get("eta", "1"), to_double);
+    for(std::size_t ii=0; ii<std::min<std::size_t>(eta_in.size(), 2); ii++) {
+      eta(ii) = eta_in[ii];
+    }
+    if(degree == 0) eta(1) = 0.0;
+    GridControl grid_ctrl;
+    grid_ctrl.warm_start = opt.count("warm-start") > 0;
+    grid_ctrl.nthreads = to_int(get("threads", "1"));
+    grid_ctrl.band_type = to_band_type(get("band-type", "constant"));
+    std::string loo = get("loo", "refit");
+    if(loo != "refit" && loo != "downdate") {
+      throw std::invalid_argument("loo must be refit or downdate.");
+    }
+    if(pos[0] == "fit") {
+      int family = to_int(get("family", ""));
+      double nu = get_nu(family, opt);
+      if(!opt.count("band")) throw std::invalid_argument("--band is required.");
+      double band = to_double(opt["band"]);
+      std::vector<double> x0;
+      if(opt.count("x0")) {
+        x0 = to_vector<double>(opt["x0"], to_double);
+        std::sort(x0.begin(), x0.end());
+      } else {
+        int nx = to_int(get("nx", "100"));
+        for(int ii=0; ii<nx; ii++) {
+          x0.push_back(nx == 1 ? x(0) :
+                       x(0) + (x(n-1) - x(0)) * ii / (nx - 1.0));
+        }
+      }
+      Map<VectorXd> x0_(x0.data(), x0.size());
+      GridFit fit;
+      MatrixXd bin_err;
+      if(opt.count("nbin")) {
+        if(grid_ctrl.band_type != BandType::Constant) {
+          throw std::invalid_argument("--nbin requires --band-type constant.");
+        }
+        std::vector<int> nbin = to_vector<int>(opt["nbin"], to_int);
+        nbin.resize(2, 0);
+        BinnedData bin;
+        bin_data(data.u1(), data.u2(), x, family, nu, nbin[0], nbin[1], bin);
+        fit_grid(bin.utrans, bin.x, x0_, std::vector<int>(), family, nu,
+                 degree, kernel, band, eta, grid_ctrl, fit, bin.freq.data());
+        bin_error(get_utrans(data, family, nu, prefix, ut, ut_cache),
+                  x, x0_, std::vector<int>(), family, nu, degree, kernel,
+                  band, fit.coef, grid_ctrl, bin_err);
+      } else {
+        fit_grid(get_utrans(data, family, nu, prefix, ut, ut_cache),
+                 x, x0_, std::vector<int>(), family, nu, degree, kernel, band,
+                 eta, grid_ctrl, fit);
+      }
+      std::cout << "x0,eta,eta_slope,se,par,convergence,niter";
+      if(bin_err.size()) std::cout << ",bin_nll,bin_eta";
+      std::cout << '\n';
+      std::cout.precision(15);
+      for(std::size_t ii=0; ii<x0.size(); ii++) {
+        std::cout << x0[ii] << ',' << fit.coef(0,ii) << ','
+                  << (degree == 1 ? fit.coef(1,ii) : 0.0) << ','
+                  << fit.se(0,ii) << ','
+                  << theta_eta<double>(fit.coef(0,ii), family) << ','
+                  << fit.convergence[ii] << ',' << fit.niter[ii];
+        if(bin_err.size()) {
+          std::cout << ',' << bin_err(0,ii) << ',' << bin_err(1,ii);
+        }
+        std::cout << '\n';
+      }
+      int nempty = std::count(fit.convergence.begin(),
+                              fit.convergence.end(), 4);
+      if(nempty > 0) {
+        std::cerr << "localcop: no observations with positive weight at "
+                  << nempty << " of the x0 values (convergence code 4)."
+                  << std::endl;
+      }
+    } else {
+      std::vector<int> family = to_vector<int>(get("family", "1,2,3,4,5"),
+                                               to_int);
+      std::vector<double> nu;
+      for(int fam : family) nu.push_back(get_nu(fam, opt));
+      std::vector<double> band = opt.count("band") ?
+        to_vector<double>(opt["band"], to_double) :
+        default_band(x, to_int(get("nband", "6")), grid_ctrl.band_type);
+      std::vector<int> xind = cv_index(n, to_int(get("xind", "100")));
+      CVControl cv_ctrl;
+      static_cast<GridControl&>(cv_ctrl) = grid_ctrl;
+      cv_ctrl.cv_all = opt.count("cv-all") > 0;
+      cv_ctrl.loo_steps = (loo == "downdate") ? 2 : 0;
+      // as cv_select(), with the marginal transformations possibly cached
+      std::vector<CVSelect> cv;
+      std::vector<double> cveta;
+      for(std::size_t ifam=0; ifam<family.size(); ifam++) {
+        Map<const MatrixXd, 0, OuterStride<> > utf =
+          get_utrans(data, family[ifam], nu[ifam], prefix, ut, ut_cache);
+        for(std::size_t ib=0; ib<band.size(); ib++) {
+          double cvll = cv_loglik(utf, x, xind, family[ifam], nu[ifam],
+                                  degree, kernel, band[ib], eta, cv_ctrl,
+                                  cveta);
+          cv.push_back({family[ifam], nu[ifam], band[ib], cvll});
+        }
+      }
+      int isel = -1;
+      for(std::size_t ii=0; ii<cv.size(); ii++) {
+        if(std::isfinite(cv[ii].cv) && (isel < 0 || cv[ii].cv > cv[isel].cv)) {
+          isel = ii;
+        }
+      }
+      std::cout << "family,nu,band,cv,selected\n";
+      std::cout.precision(15);
+      for(std::size_t ii=0; ii<cv.size(); ii++) {
+        std::cout << cv[ii].family << ',' << cv[ii].nu << ','
+                  << cv[ii].band << ',' << cv[ii].cv << ','
+                  << (static_cast<int>(ii) == isel) << '\n';
+      }
+    }
+    return 0;
+  }
+
+} // end namespace
+
+int main(int argc, char* argv[]) {
+  try {
+    return run(argc, argv);
+  } catch(const std::exception& e) {
+    std::cerr << "localcop: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,153 @@
+/// @file test-colfile.cpp
+///
+/// @brief Tests of the column files written by `ColWriter` and `write_utrans()`.
+///
+/// Run by `ctest` from the CMake build, in a working directory where the test files can be written.  Returns a nonzero exit status if any check fails.
+
+#include "LocalCop/colfile.hpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+
+using namespace LocalCop;
+
+namespace {
+
+  int nfail = 0;
+
+  void check(bool ok, const std::string& msg) {
+    if(!ok) {
+      std::cerr << "FAIL: " << msg << std::endl;
+      nfail++;
+    }
+  }
+
+  bool file_exists(const std::string& path) {
+    return std::ifstream(path).good();
+  }
+
+  /// Dataset with many ties in `x`, where `u1` increases with the row index, such that the original order of tied rows can be recovered.
+  MatrixXd make_data(int n) {
+    MatrixXd data(n, 3);
+    for(int ii=0; ii<n; ii++) {
+      data(ii,0) = (ii + .5) / n;
+      data(ii,1) = std::fmod((ii + .5) * 0.6180339887498949, 1.0);
+      data(ii,2) = ((ii * 7919) % 97) / 97.0;
+    }
+    return data;
+  }
+
+  /// Write a dataset in blocks of irregular sizes.
+  void write_data(const std::string& path, const MatrixXd& data, int dtype,
+                  std::size_t chunk) {
+    ColWriter writer(path, {"u1", "u2", "x"}, 2, dtype, chunk);
+    int n = data.rows();
+    int block = 1;
+    for(int i0=0; i0<n; i0+=block, block=3*block+1) {
+      writer.append(data.middleRows(i0, std::min(block, n - i0)));
+    }
+    check(writer.nrow() == static_cast<uint64_t>(n), "rows appended");
+    writer.finish();
+    check(!file_exists(path + ".run0"), "run files removed");
+  }
+
+  /// Check that a file contains the rows of `data` sorted stably by `x`.
+  void check_sorted(const std::string& path, const MatrixXd& data,
+                    const std::string& what) {
+    ColFile file(path);
+    int n = data.rows();
+    check(file.nrow() == n && file.ncol() == 3, what + ": dimensions");
+    check(file.sorted(), what + ": sorted flag");
+    check(file.col_index("x") == 2, what + ": column names");
+    MatrixXd out = file.matrix_copy(0, 3);
+    bool sorted = true, stable = true, same = true;
+    for(int ii=0; ii<n; ii++) {
+      if(ii > 0) {
+        sorted = sorted && out(ii-1,2) <= out(ii,2);
+        if(out(ii-1,2) == out(ii,2)) stable = stable && out(ii-1,0) < out(ii,0);
+      }
+      int jj = static_cast<int>(out(ii,0) * n);
+      if(jj < 0 || jj >= n) {
+        same = false;
+        continue;
+      }
+      if(file.is_double()) {
+        same = same && out.row(ii) == data.row(jj);
+      } else {
+        same = same &&
+          out.row(ii) == data.row(jj).cast<float>().cast<double>();
+      }
+    }
+    check(sorted, what + ": rows sorted by x");
+    check(stable, what + ": tied rows in their original order");
+    check(same, what + ": rows unchanged");
+  }
+
+} // end namespace
+
+int main() {
+  try {
+    const int n = 10007;
+    MatrixXd data = make_data(n);
+    // single run in memory, and external merge sort of 11 runs
+    write_data("test-colfile-1.lcc", data, 8, n + 1);
+    write_data("test-colfile-11.lcc", data, 8, 1000);
+    check_sorted("test-colfile-1.lcc", data, "float64, one run");
+    check_sorted("test-colfile-11.lcc", data, "float64, several runs");
+    {
+      ColFile f1("test-colfile-1.lcc");
+      ColFile f11("test-colfile-11.lcc");
+      check(f1.matrix(0, 3) == f11.matrix(0, 3),
+            "same file from one and several runs");
+    }
+    // float32
+    write_data("test-colfile-f32.lcc", data, 4, 1000);
+    check_sorted("test-colfile-f32.lcc", data, "float32");
+    {
+      ColFile f32("test-colfile-f32.lcc");
+      check(!f32.is_double(), "float32: data type");
+      bool thrown = false;
+      try {
+        f32.matrix(0, 3);
+      } catch(const std::logic_error&) {
+        thrown = true;
+      }
+      check(thrown, "float32: no zero-copy access");
+    }
+    // cached marginal transformations
+    {
+      const int family = 2;
+      const double nu = 5.0;
+      ColFile dfile("test-colfile-11.lcc");
+      write_utrans(dfile, 0, 1, family, nu, "test-colfile-ut.lcc", 999);
+      ColFile ut("test-colfile-ut.lcc");
+      MatrixXd ut0(n, utrans_size(family));
+      utrans(dfile.column(0), dfile.column(1), nu, family, ut0);
+      check(ut.matrix(0, ut.ncol()) == ut0, "utrans: values");
+      check(utrans_matches(ut, dfile, 0, 1, family, nu),
+            "utrans: cache of the same data accepted");
+      check(!utrans_matches(ut, dfile, 0, 1, family, 6.0),
+            "utrans: cache with other nu rejected");
+      check(!utrans_matches(ut, dfile, 1, 0, family, nu),
+            "utrans: cache of other columns rejected");
+      // same x and dimensions, but different (u1, u2) pairs
+      MatrixXd data2 = data;
+      for(int ii=0; ii<n; ii++) data2(ii,1) = data((ii + 1) % n, 1);
+      write_data("test-colfile-other.lcc", data2, 8, 1000);
+      ColFile dfile2("test-colfile-other.lcc");
+      check(!utrans_matches(ut, dfile2, 0, 1, family, nu),
+            "utrans: cache of other data with the same dimensions rejected");
+    }
+    for(const char* path : {"test-colfile-1.lcc", "test-colfile-11.lcc",
+                            "test-colfile-f32.lcc", "test-colfile-ut.lcc",
+                            "test-colfile-other.lcc"}) {
+      std::remove(path);
+    }
+  } catch(const std::exception& e) {
+    std::cerr << "FAIL: " << e.what() << std::endl;
+    nfail++;
+  }
+  if(nfail == 0) std::cout << "All column file tests passed." << std::endl;
+  return nfail == 0 ? 0 : 1;
+}
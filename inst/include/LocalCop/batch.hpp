@@ -0,0 +1,252 @@
+/// @file batch.hpp
+///
+/// @brief Batched copula log-densities and their derivatives on the calibration scale.
+///
+/// These are the same calculations as `dgaussian_eta()`, `dclayton_eta()`, `dgumbel_eta()` and `dfrank_eta()`, reorganized to evaluate a batch of observations one operation at a time, such that the transcendental functions are computed by `vexp()` and `vlog()` and the arithmetic can be vectorized by the compiler.  The inputs are the marginal transformations of the uniform variables calculated by `utrans()`, such that only the terms involving the copula parameter are computed here.  Batches are processed in blocks of `BATCH_SIZE` observations using scratch arrays on the stack.
+
+#ifndef LOCALCOP_BATCH_HPP
+#define LOCALCOP_BATCH_HPP
+
+#include "config.hpp"
+#include "simd.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace LocalCop {
+
+  namespace batch {
+
+    const int BATCH_SIZE = 256;
+
+    /// Gaussian copula in terms of normal quantiles `z1` and `z2`.  See `dgaussian_eta()`.
+    inline void dgaussian(const double* z1, const double* z2,
+                          const double* eta, int n,
+                          double* ld, double* d1, double* d2) {
+      double theta[BATCH_SIZE], det[BATCH_SIZE], ldet[BATCH_SIZE];
+      for(int i0=0; i0<n; i0+=BATCH_SIZE) {
+        int nb = std::min(BATCH_SIZE, n - i0);
+        for(int ii=0; ii<nb; ii++) {
+          theta[ii] = 2.0 * eta[i0+ii];
+        }
+        vexp(theta, theta, nb);
+        for(int ii=0; ii<nb; ii++) {
+          theta[ii] = (theta[ii] - 1.0) / (theta[ii] + 1.0);
+          det[ii] = 1.0 - theta[ii] * theta[ii];
+        }
+        vlog(det, ldet, nb);
+        for(int ii=0; ii<nb; ii++) {
+          double th = theta[ii];
+          double th2 = th * th;
+          double y1 = z1[i0+ii];
+          double y2 = z2[i0+ii];
+          double a = y1*y1 + y2*y2;
+          double b = y1*y2;
+          ld[i0+ii] = -.5 * ((th2 * a - 2.0 * th * b) / det[ii] + ldet[ii]);
+          if(d1) {
+            d1[i0+ii] = th - (th * a - (1.0 + th2) * b) / det[ii];
+            d2[i0+ii] = det[ii] - ((1.0 + th2) * a - 4.0 * th * b) / det[ii];
+          }
+        }
+      }
+    }
+
+    /// Clayton copula in terms of `log(u1)` and `log(u2)`.  See `dclayton_eta()`.
+    inline void dclayton(const double* lu1, const double* lu2,
+                         const double* eta, int n,
+                         double* ld, double* d1, double* d2) {
+      double theta[BATCH_SIZE];
+      double pow_u1[BATCH_SIZE], pow_u2[BATCH_SIZE];
+      double log_S[BATCH_SIZE], log_th[BATCH_SIZE];
+      for(int i0=0; i0<n; i0+=BATCH_SIZE) {
+        int nb = std::min(BATCH_SIZE, n - i0);
+        const double* log_u1 = lu1 + i0;
+        const double* log_u2 = lu2 + i0;
+        vexp(eta + i0, theta, nb);
+        for(int ii=0; ii<nb; ii++) {
+          pow_u1[ii] = -theta[ii] * log_u1[ii];
+          pow_u2[ii] = -theta[ii] * log_u2[ii];
+          log_th[ii] = 1.0 + theta[ii];
+        }
+        vexp(pow_u1, pow_u1, nb);
+        vexp(pow_u2, pow_u2, nb);
+        for(int ii=0; ii<nb; ii++) {
+          log_S[ii] = pow_u1[ii] + pow_u2[ii] - 1.0;
+        }
+        vlog(log_S, log_S, nb);
+        vlog(log_th, log_th, nb);
+        for(int ii=0; ii<nb; ii++) {
+          double th = theta[ii];
+          double itheta = 1.0 / th;
+          double c = 2.0 + itheta;
+          double lu = log_u1[ii] + log_u2[ii];
+          ld[i0+ii] = log_th[ii] - (1.0 + th) * lu - c * log_S[ii];
+          if(d1) {
+            double iS = 1.0 / (pow_u1[ii] + pow_u2[ii] - 1.0);
+            double S1 = -(log_u1[ii] * pow_u1[ii] + log_u2[ii] * pow_u2[ii]) * iS;
+            double S2 = (log_u1[ii] * log_u1[ii] * pow_u1[ii] +
+                         log_u2[ii] * log_u2[ii] * pow_u2[ii]) * iS;
+            S2 -= S1 * S1;
+            double itheta2 = itheta * itheta;
+            double l1 = 1.0/(1.0 + th) - lu + itheta2 * log_S[ii] - c * S1;
+            double l2 = -1.0/((1.0 + th) * (1.0 + th));
+            l2 += -2.0 * itheta2 * itheta * log_S[ii] + 2.0 * itheta2 * S1;
+            l2 -= c * S2;
+            d1[i0+ii] = th * l1;
+            d2[i0+ii] = th * l1 + th * th * l2;
+          }
+        }
+      }
+    }
+
+    /// Gumbel copula in terms of `log(u1)`, `log(u2)`, `log(-log(u1))` and `log(-log(u2))`.  See `dgumbel_eta()`.
+    inline void dgumbel(const double* lu1, const double* lu2,
+                        const double* llu1, const double* llu2,
+                        const double* eta, int n,
+                        double* ld, double* d1, double* d2) {
+      double s[BATCH_SIZE], t1[BATCH_SIZE], t2[BATCH_SIZE];
+      double w1[BATCH_SIZE], w2[BATCH_SIZE], L[BATCH_SIZE];
+      double A[BATCH_SIZE], log_B[BATCH_SIZE];
+      for(int i0=0; i0<n; i0+=BATCH_SIZE) {
+        int nb = std::min(BATCH_SIZE, n - i0);
+        const double* lt1 = llu1 + i0;
+        const double* lt2 = llu2 + i0;
+        vexp(eta + i0, s, nb);
+        for(int ii=0; ii<nb; ii++) {
+          t1[ii] = -lu1[i0+ii];
+          t2[ii] = -lu2[i0+ii];
+        }
+        // L = logspace_add(theta * lt1, theta * lt2)
+        for(int ii=0; ii<nb; ii++) {
+          double theta = 1.0 + s[ii];
+          double a1 = theta * lt1[ii];
+          double a2 = theta * lt2[ii];
+          L[ii] = std::max(a1, a2);
+          w1[ii] = -std::abs(a1 - a2);
+        }
+        vexp(w1, w1, nb);
+        for(int ii=0; ii<nb; ii++) w2[ii] = 1.0 + w1[ii];
+        vlog(w2, w2, nb);
+        for(int ii=0; ii<nb; ii++) {
+          double theta = 1.0 + s[ii];
+          L[ii] += w2[ii];
+          A[ii] = L[ii] / theta;
+          // log-weights of lt1 and lt2 in derivatives of L
+          w1[ii] = theta * lt1[ii] - L[ii];
+          w2[ii] = theta * lt2[ii] - L[ii];
+        }
+        vexp(A, A, nb);
+        vexp(w1, w1, nb);
+        vexp(w2, w2, nb);
+        for(int ii=0; ii<nb; ii++) log_B[ii] = A[ii] + s[ii];
+        vlog(log_B, log_B, nb);
+        for(int ii=0; ii<nb; ii++) {
+          double theta = 1.0 + s[ii];
+          double itheta = 1.0 / theta;
+          ld[i0+ii] = s[ii] * (lt1[ii] + lt2[ii]) +
+            (itheta - 2.0) * L[ii] - A[ii] + log_B[ii] + t1[ii] + t2[ii];
+          if(d1) {
+            double L1 = w1[ii] * lt1[ii] + w2[ii] * lt2[ii];
+            double L2 = w1[ii] * lt1[ii] * lt1[ii] +
+              w2[ii] * lt2[ii] * lt2[ii] - L1 * L1;
+            double m = L[ii] * itheta;
+            double m1 = (L1 - m) * itheta;
+            double m2 = (L2 - 2.0 * m1) * itheta;
+            double A1 = A[ii] * m1;
+            double A2 = A[ii] * (m2 + m1 * m1);
+            double B = A[ii] + s[ii];
+            double B1 = (A1 + 1.0) / B;
+            double l1 = lt1[ii] + lt2[ii] - m * itheta +
+              (itheta - 2.0) * L1 - A1 + B1;
+            double l2 = 2.0 * (m - L1) * itheta * itheta;
+            l2 += (itheta - 2.0) * L2 - A2 + A2 / B - B1 * B1;
+            d1[i0+ii] = s[ii] * l1;
+            d2[i0+ii] = s[ii] * l1 + s[ii] * s[ii] * l2;
+          }
+        }
+      }
+    }
+
+    /// Frank copula.  See `dfrank_eta()`.
+    inline void dfrank(const double* u1, const double* u2,
+                       const double* eta, int n,
+                       double* ld, double* d1, double* d2) {
+      double e0[BATCH_SIZE], e1[BATCH_SIZE], e2[BATCH_SIZE];
+      double N[BATCH_SIZE], dens[BATCH_SIZE];
+      for(int i0=0; i0<n; i0+=BATCH_SIZE) {
+        int nb = std::min(BATCH_SIZE, n - i0);
+        for(int ii=0; ii<nb; ii++) {
+          double theta = eta[i0+ii];
+          e0[ii] = -theta;
+          e1[ii] = -theta * u1[i0+ii];
+          e2[ii] = -theta * u2[i0+ii];
+        }
+        vexp(e0, e0, nb);
+        vexp(e1, e1, nb);
+        vexp(e2, e2, nb);
+        for(int ii=0; ii<nb; ii++) {
+          double term3 = e0[ii] - 1.0;
+          N[ii] = term3 + (e1[ii] - 1.0) * (e2[ii] - 1.0);
+          dens[ii] = -eta[i0+ii] * term3 * e1[ii] * e2[ii] / (N[ii] * N[ii]);
+        }
+        vlog(dens, ld + i0, nb);
+        if(d1) {
+          for(int ii=0; ii<nb; ii++) {
+            double theta = eta[i0+ii];
+            double v1 = u1[i0+ii];
+            double v2 = u2[i0+ii];
+            double N1 = -e0[ii] - v1 * e1[ii] * (e2[ii] - 1.0) -
+              v2 * e2[ii] * (e1[ii] - 1.0);
+            double N2 = e0[ii] + v1 * v1 * e1[ii] * (e2[ii] - 1.0) +
+              v2 * v2 * e2[ii] * (e1[ii] - 1.0) + 2.0 * v1 * v2 * e1[ii] * e2[ii];
+            N1 /= N[ii];
+            N2 /= N[ii];
+            double itheta = 1.0 / theta;
+            double iterm3 = 1.0 / (e0[ii] - 1.0);
+            d1[i0+ii] = itheta - e0[ii] * iterm3 - (v1 + v2) - 2.0 * N1;
+            d2[i0+ii] = -itheta * itheta - e0[ii] * iterm3 * iterm3 -
+              2.0 * (N2 - N1 * N1);
+          }
+        }
+      }
+    }
+
+  } // end namespace batch
+
+  /// Whether a family has a batched log-density, i.e., is one of the one-parameter families or their rotations.
+  inline bool has_lpdf_batch(int family) {
+    return family % 10 != 2;
+  }
+
+  /// Batched copula log-density on the calibration scale and its first two derivatives.
+  ///
+  /// @param[in] ut Pointer to the column-major matrix of marginal transformations of the uniform variables, with `utrans_size(family)` columns.  See `utrans()`.
+  /// @param[in] stride Distance between the columns of `ut`, i.e., its number of rows, which may be larger than `n`.
+  /// @param[in] eta Pointer to dependence parameters on the calibration scale.
+  /// @param[in] n Number of observations.
+  /// @param[in] family Copula family.  Must satisfy `has_lpdf_batch()`.
+  /// @param[out] ld Pointer to log-densities.
+  /// @param[out] d1 Pointer to first derivatives with respect to `eta`.  If `nullptr`, neither derivative is calculated.
+  /// @param[out] d2 Pointer to second derivatives with respect to `eta`.
+  inline void lpdf_eta_batch(const double* ut, int stride,
+                             const double* eta, int n, int family,
+                             double* ld, double* d1, double* d2) {
+    switch(family % 10) {
+    case 1:
+      batch::dgaussian(ut, ut + stride, eta, n, ld, d1, d2);
+      break;
+    case 3:
+      batch::dclayton(ut, ut + stride, eta, n, ld, d1, d2);
+      break;
+    case 4:
+      batch::dgumbel(ut, ut + stride, ut + 2*stride, ut + 3*stride,
+                     eta, n, ld, d1, d2);
+      break;
+    default:
+      batch::dfrank(ut, ut + stride, eta, n, ld, d1, d2);
+      break;
+    }
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_BATCH_HPP
@@ -0,0 +1,236 @@
+/// @file binned.hpp
+///
+/// @brief Binned approximation to the local likelihood for large datasets.
+///
+/// The observations are binned along `x` into `nbin_x` intervals of equal width, and optionally along `(u1, u2)` into a 2-D histogram of `nbin_u x nbin_u` equal cells within each interval.  Each nonempty cell is replaced by at most four weighted pseudo-observations at the mean of `x` in the cell, which match the first two moments of the normal scores of `(u1, u2)` in the cell.  The local likelihood of the binned data is then a weighted sum over pseudo-observations (see `LocalFit::set_freq()`), the cost of which depends on the number of nonempty cells rather than the number of observations.  Without binning along `(u1, u2)`, only the covariates are replaced by their bin means, which approximates the kernel weights but not the copula log-densities.
+///
+/// The error of the approximation can be measured against the exact local likelihood with `bin_error()`.
+
+#ifndef LOCALCOP_BINNED_HPP
+#define LOCALCOP_BINNED_HPP
+
+#include "fitgrid.hpp"
+#include <vector>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+namespace LocalCop {
+
+  /// Binned dataset.
+  struct BinnedData {
+    /// Covariate of each row, sorted.
+    VectorXd x;
+    /// Marginal transformations of each row.  See `utrans()`.
+    MatrixXd utrans;
+    /// Frequency weight of each row, i.e., the number of observations it represents.
+    VectorXd freq;
+    /// The (0-based) index of the first row of the cell of each observation.  For cells replaced by sigma points, leaving this row out with `LocalFit::drop_obs()` removes the observation from only the first of the four sigma points of the cell, which changes their mean and covariance slightly.
+    std::vector<int> cell;
+  };
+
+  /// Bin a dataset along `x`, and optionally along `(u1, u2)`.
+  ///
+  /// Within each cell, the normal scores `z = qnorm(u)` of the responses are summarized by their mean `m` and covariance `S = L L'`, and the cell is replaced by the four sigma points `m +/- sqrt(2) L[,j]`, each with a quarter of the weight of the cell.  These have the same first two moments as the observations in the cell, such that the binned log-likelihood is exact for the Gaussian copula (whose log-density is quadratic in `z`) and accurate to second order for the others.  Cells with at most four observations are kept as they are.
+  ///
+  /// @param[in] u1 Vector of first uniform variables, sorted by `x`.
+  /// @param[in] u2 Vector of second uniform variables, sorted by `x`.
+  /// @param[in] x Sorted vector of covariates.
+  /// @param[in] family Copula family.
+  /// @param[in] nu Second copula parameter.
+  /// @param[in] nbin_x Number of bins along `x`.
+  /// @param[in] nbin_u Number of bins along each of `u1` and `u2`, or 0 for no binning along `(u1, u2)`.
+  /// @param[out] out Binned dataset.
+  inline void bin_data(cRefVector_t<double>& u1, cRefVector_t<double>& u2,
+                       cRefVector_t<double>& x, int family, double nu,
+                       int nbin_x, int nbin_u, BinnedData& out) {
+    int n = x.size();
+    if(nbin_x < 1 || nbin_u < 0) {
+      throw std::invalid_argument("nbin_x must be positive and nbin_u nonnegative.");
+    }
+    if(n == 0) throw std::invalid_argument("x must not be empty.");
+    if(!std::is_sorted(x.data(), x.data() + n)) {
+      throw std::invalid_argument("x must be sorted.");
+    }
+    const double zmax = 8.2; // normal score of the largest double below 1
+    double xmin = x(0);
+    double width = (x(n-1) - xmin) / nbin_x;
+    auto xbin = [&](int ii) {
+      if(width <= 0.0) return 0;
+      return std::min(static_cast<int>((x(ii) - xmin) / width), nbin_x - 1);
+    };
+    // rows of the binned dataset
+    std::vector<double> rx, ru1, ru2, rf;
+    auto add_row = [&](double xr, double v1, double v2, double f) {
+      rx.push_back(xr);
+      ru1.push_back(v1);
+      ru2.push_back(v2);
+      rf.push_back(f);
+    };
+    std::vector<int> cell(n);
+    // per (u1, u2) bin: count, sums of x, z1, z2, z1^2, z2^2, z1*z2
+    int nu2 = nbin_u * nbin_u;
+    std::vector<int> slot(nu2, -1);
+    std::vector<int> used;
+    std::vector<std::array<double, 7> > sums;
+    std::vector<int> row0; // first row of each cell
+    for(int i0=0; i0<n; ) {
+      // observations [i0, i1) in the same x bin
+      int bx = xbin(i0);
+      int i1 = i0 + 1;
+      while(i1 < n && xbin(i1) == bx) i1++;
+      if(nbin_u == 0) {
+        // one row per observation, at the bin mean of x
+        double xb = x.segment(i0, i1 - i0).mean();
+        for(int ii=i0; ii<i1; ii++) {
+          cell[ii] = rx.size();
+          add_row(xb, u1(ii), u2(ii), 1.0);
+        }
+        i0 = i1;
+        continue;
+      }
+      std::vector<int> key(i1 - i0);
+      for(int ii=i0; ii<i1; ii++) {
+        int k1 = std::min(static_cast<int>(u1(ii) * nbin_u), nbin_u - 1);
+        int k2 = std::min(static_cast<int>(u2(ii) * nbin_u), nbin_u - 1);
+        int kk = std::max(k1, 0) * nbin_u + std::max(k2, 0);
+        key[ii-i0] = kk;
+        if(slot[kk] < 0) {
+          slot[kk] = sums.size();
+          used.push_back(kk);
+          sums.push_back({0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
+        }
+        std::array<double, 7>& sm = sums[slot[kk]];
+        double z1 = qnorm(u1(ii));
+        double z2 = qnorm(u2(ii));
+        sm[0] += 1.0;
+        sm[1] += x(ii);
+        sm[2] += z1;
+        sm[3] += z2;
+        sm[4] += z1 * z1;
+        sm[5] += z2 * z2;
+        sm[6] += z1 * z2;
+      }
+      // sigma points of the cells with more than four observations
+      row0.assign(sums.size(), -1);
+      for(std::size_t jj=0; jj<sums.size(); jj++) {
+        const std::array<double, 7>& sm = sums[jj];
+        double m = sm[0];
+        if(m <= 4.0) continue;
+        double xm = sm[1] / m;
+        Vector2d zm(sm[2] / m, sm[3] / m);
+        Matrix2d S;
+        S(0,0) = std::max(sm[4] / m - zm(0) * zm(0), 0.0);
+        S(1,1) = std::max(sm[5] / m - zm(1) * zm(1), 0.0);
+        S(0,1) = S(1,0) = sm[6] / m - zm(0) * zm(1);
+        // symmetric square root, which exists even if S is singular
+        SelfAdjointEigenSolver<Matrix2d> eig(S);
+        Matrix2d L = eig.eigenvectors() *
+          eig.eigenvalues().cwiseMax(0.0).cwiseSqrt().asDiagonal();
+        row0[jj] = rx.size();
+        for(int kk=0; kk<4; kk++) {
+          Vector2d z = zm + ((kk % 2) ? -1.0 : 1.0) * std::sqrt(2.0) * L.col(kk / 2);
+          z = z.cwiseMax(-zmax).cwiseMin(zmax);
+          add_row(xm, pnorm(z(0)), pnorm(z(1)), m / 4.0);
+        }
+      }
+      for(int ii=i0; ii<i1; ii++) {
+        int jj = slot[key[ii-i0]];
+        if(row0[jj] >= 0) {
+          cell[ii] = row0[jj];
+        } else {
+          // small cells are kept as they are
+          cell[ii] = rx.size();
+          add_row(x(ii), u1(ii), u2(ii), 1.0);
+        }
+      }
+      for(int kk : used) slot[kk] = -1;
+      used.clear();
+      sums.clear();
+      i0 = i1;
+    }
+    // sort rows by x, which only reorders rows within the same x bin
+    int nrow = rx.size();
+    std::vector<int> ord(nrow);
+    std::iota(ord.begin(), ord.end(), 0);
+    std::stable_sort(ord.begin(), ord.end(),
+                     [&rx](int i, int j) { return rx[i] < rx[j]; });
+    std::vector<int> rank(nrow);
+    for(int jj=0; jj<nrow; jj++) rank[ord[jj]] = jj;
+    VectorXd cu1(nrow), cu2(nrow);
+    out.x.resize(nrow);
+    out.freq.resize(nrow);
+    for(int jj=0; jj<nrow; jj++) {
+      out.x(jj) = rx[ord[jj]];
+      cu1(jj) = ru1[ord[jj]];
+      cu2(jj) = ru2[ord[jj]];
+      out.freq(jj) = rf[ord[jj]];
+    }
+    out.cell.resize(n);
+    for(int ii=0; ii<n; ii++) out.cell[ii] = rank[cell[ii]];
+    out.utrans.resize(nrow, utrans_size(family));
+    utrans(cu1, cu2, nu, family, out.utrans);
+    return;
+  }
+
+  /// Error of binned local likelihood estimates with respect to the exact local likelihood.
+  ///
+  /// At each element of `x0`, a single Newton step of the exact local likelihood is taken from the binned estimate.  The decrease in the exact negative local log-likelihood estimates how far the binned estimate is from the exact optimum on the scale of the objective function, and the size of the step in `eta` estimates its error on the scale of the parameter.
+  ///
+  /// @param[in] utrans Matrix of marginal transformations of the full dataset.
+  /// @param[in] x Vector of covariates of the full dataset.
+  /// @param[in] x0 Vector of covariate values at which the local likelihood was fit.
+  /// @param[in] drop Indices of the observations left out of each fit, as in `fit_grid()`.
+  /// @param[in] family Copula family.
+  /// @param[in] nu Second copula parameter.
+  /// @param[in] degree Degree of the local polynomial.
+  /// @param[in] kernel Kernel function.
+  /// @param[in] band Kernel bandwidth.
+  /// @param[in] coef A `npar x nx` matrix of binned local likelihood estimates, as returned in `GridFit::coef`.
+  /// @param[in] ctrl Control parameters.  Only `analytic`, `nthreads`, and `band_type` are used.
+  /// @param[out] err A `2 x nx` matrix, the first row of which is the decrease in the exact negative local log-likelihood, and the second is the change in `eta` divided by its standard error.
+  inline void bin_error(cRefMatrix_t<double>& utrans,
+                        cRefVector_t<double>& x,
+                        cRefVector_t<double>& x0,
+                        const std::vector<int>& drop,
+                        int family, double nu, int degree,
+                        Kernel kernel, double band,
+                        cRefMatrix_t<double>& coef,
+                        const GridControl& ctrl, MatrixXd& err) {
+    int nx = x0.size();
+    int npar = locpoly_size(1, degree);
+    if(coef.rows() != std::max(2, npar) || coef.cols() != nx) {
+      throw std::invalid_argument("coef must be a matrix with one row per coefficient and length(x0) columns.");
+    }
+    if(drop.size() != 0 && static_cast<int>(drop.size()) != nx) {
+      throw std::invalid_argument("drop must have length 0 or length(x0).");
+    }
+    int nthreads = get_nthreads(ctrl.nthreads, nx);
+    std::vector<LocalFit> locfit;
+    locfit.reserve(nthreads);
+    for(int it=0; it<nthreads; it++) {
+      locfit.emplace_back(utrans, x, family, nu, degree, kernel, band);
+      locfit[it].set_control(1, 0.0);
+      locfit[it].set_analytic(ctrl.analytic);
+      locfit[it].set_band_type(ctrl.band_type);
+    }
+    err.resize(2, nx);
+    parallel_for(nx, nthreads, [&](int ii, int it) {
+      LocalFit& lf = locfit[it];
+      VectorXd beta = coef.col(ii);
+      VectorXd se(npar);
+      lf.set_x0(x0(ii), drop.size() ? drop[ii] : -1);
+      double nll0 = lf.nll(beta);
+      lf.fit(beta);
+      lf.std_err(se);
+      err(0,ii) = nll0 - lf.nll();
+      err(1,ii) = std::abs(beta(0) - coef(0,ii)) / se(0);
+    });
+    return;
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_BINNED_HPP
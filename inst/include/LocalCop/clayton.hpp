@@ -39,7 +39,37 @@ namespace LocalCop {
     if(give_log) return logans; else return exp(logans);
   }
   VECTORIZE4_ttti(hclayton)    
+
+  /// Calculate the inverse of the Clayton copula h-function with respect to u2.
+  ///
+  /// This is `u2 = (1 + u1^(-theta) * (p^(-theta/(1+theta)) - 1))^(-1/theta)`.
+  ///
+  /// @param[in] p Probability.
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] theta Parameter of the Clayton copula with the range $[0,\infty]$.
+  ///
+  /// @return Value of `u2` such that `hclayton(u1, u2, theta) = p`.
+  template <class Type>
+  Type hinvclayton(Type p, Type u1, Type theta) {
+    Type term = expm1(-theta / (Type(1.0) + theta) * log(p));
+    return exp(-log1p(exp(-theta * log(u1)) * term) / theta);
+  }
       
+  /// Calculate Clayton copula PDF in terms of the log-uniforms.
+  ///
+  /// @param[in] log_u1 Logarithm of the first uniform variable.
+  /// @param[in] log_u2 Logarithm of the second uniform variable.
+  /// @param[in] theta Parameter of the Clayton copula with the range $[0,\infty]$.
+  /// @param give_log Whether or not to return on the log scale.
+  ///
+  /// @return Value of the copula PDF.
+  template <class Type>
+  Type dclayton_log(Type log_u1, Type log_u2, Type theta, int give_log=0) {
+    Type logans = log(Type(1.0) + theta) - (Type(1.0) + theta) * (log_u1 + log_u2);
+    logans -= (Type(2.0) + Type(1.0)/theta) * log(exp(-theta * log_u1) + exp(-theta * log_u2) - Type(1.0));
+    if(give_log) return logans; else return exp(logans);
+  }
+
   /// Calculate Clayton copula PDF.
   ///
   /// @param[in] u1 First uniform variable.
@@ -50,12 +80,53 @@ namespace LocalCop {
   /// @return Value of the copula PDF.
   template <class Type>
   Type dclayton(Type u1, Type u2, Type theta, int give_log=0) {
-    Type logans = log(Type(1.0) + theta) - (Type(1.0) + theta) * (log(u1) + log(u2));
-    logans -= (Type(2.0) + Type(1.0)/theta) * log(pow(u1, -theta) + pow(u2, -theta) - Type(1.0));
-    if(give_log) return logans; else return exp(logans);
+    return dclayton_log(Type(log(u1)), Type(log(u2)), theta, give_log);
   }
   VECTORIZE4_ttti(dclayton)
       
+  /// Calculate Clayton copula log-PDF and its derivatives on the calibration scale.
+  ///
+  /// The copula parameter is `theta = exp(eta)`.  The derivatives are calculated from those with respect to `theta`, which in terms of `S(theta) = u1^-theta + u2^-theta - 1` are
+  ///
+  /// ```
+  /// dl/dtheta = 1/(1+theta) - log(u1 u2) + log(S)/theta^2 - (2 + 1/theta) S'/S,
+  /// d2l/dtheta2 = -1/(1+theta)^2 - 2 log(S)/theta^3 + 2 S'/(theta^2 S) - (2 + 1/theta) (S''/S - (S'/S)^2).
+  /// ```
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] eta Dependence parameter on the calibration scale.
+  /// @param[out] d1 First derivative of the log-PDF with respect to `eta`.
+  /// @param[out] d2 Second derivative of the log-PDF with respect to `eta`.
+  ///
+  /// @return Value of the copula log-PDF.
+  template <class Type>
+  Type dclayton_eta(Type u1, Type u2, Type eta, Type& d1, Type& d2) {
+    Type theta = exp(eta);
+    Type log_u1 = log(u1);
+    Type log_u2 = log(u2);
+    Type pow_u1 = exp(-theta * log_u1);
+    Type pow_u2 = exp(-theta * log_u2);
+    Type S = pow_u1 + pow_u2 - Type(1.0);
+    Type log_S = log(S);
+    // derivatives of log(S) with respect to theta
+    Type S1 = -(log_u1 * pow_u1 + log_u2 * pow_u2) / S;
+    Type S2 = (log_u1 * log_u1 * pow_u1 + log_u2 * log_u2 * pow_u2) / S;
+    S2 -= S1 * S1;
+    Type itheta = Type(1.0) / theta;
+    Type itheta2 = itheta * itheta;
+    Type c = Type(2.0) + itheta;
+    Type l1 = Type(1.0)/(Type(1.0) + theta) - (log_u1 + log_u2);
+    l1 += itheta2 * log_S - c * S1;
+    Type l2 = -Type(1.0)/((Type(1.0) + theta) * (Type(1.0) + theta));
+    l2 += -Type(2.0) * itheta2 * itheta * log_S + Type(2.0) * itheta2 * S1;
+    l2 -= c * S2;
+    // chain rule with dtheta/deta = theta
+    d1 = theta * l1;
+    d2 = d1 + theta * theta * l2;
+    return log(Type(1.0) + theta) - (Type(1.0) + theta) * (log_u1 + log_u2) - c * log_S;
+  }
+
 } // end namespace LocalCop
 
 #endif // LOCALCOP_CLAYTON_HPP
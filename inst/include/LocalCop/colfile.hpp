@@ -0,0 +1,583 @@
+/// @file colfile.hpp
+///
+/// @brief Memory-mapped columnar files for large datasets.
+///
+/// A column file consists of a 128-byte header (see `ColHeader`) followed by `ncol` columns of `nrow` values each, stored contiguously as little-endian `float64` or `float32`.  Each column starts at a multiple of 64 bytes, so that a `float64` file can be mapped into memory and passed to `LocalFit` or `fit_grid()` as an Eigen matrix with an outer stride, without copying.  Column files are written by `ColWriter`, which sorts the rows by one of the columns (usually the covariate `x`) with an external merge sort, so that datasets larger than memory can be converted in chunks.
+
+#ifndef LOCALCOP_COLFILE_HPP
+#define LOCALCOP_COLFILE_HPP
+
+#include "config.hpp"
+#include "transform.hpp"
+#include "locfit.hpp"
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace LocalCop {
+
+  /// Header of a column file.
+  struct ColHeader {
+    char magic[8]; ///< `"LCOPCOL"`, null-terminated.
+    uint32_t version; ///< Format version, currently 1.
+    uint32_t dtype; ///< Bytes per value: 8 for `float64` or 4 for `float32`.
+    uint64_t nrow; ///< Number of rows.
+    uint32_t ncol; ///< Number of columns, at most 8.
+    uint32_t flags; ///< Bit 0 is set if the rows are sorted by column `sort_col`.
+    int32_t sort_col; ///< Index of the sorting column, or -1.
+    int32_t family; ///< Copula family of the marginal transformations in the file, or -1 for data.  See `write_utrans()`.
+    double nu; ///< Second copula parameter of the marginal transformations.
+    char names[8][8]; ///< Null-terminated column names, at most 7 characters each.
+    uint64_t source; ///< Hash of the columns from which the marginal transformations were calculated, or 0 for data.  See `ColFile::column_hash()`.
+    char pad[8]; ///< Reserved.
+  };
+
+  static_assert(sizeof(ColHeader) == 128, "ColHeader must be 128 bytes.");
+
+  namespace colfile {
+
+    const char magic[8] = "LCOPCOL";
+    const uint32_t version = 1;
+    const uint32_t sorted_flag = 1;
+    const uint64_t hash_seed = 14695981039346656037ULL; // FNV-1a offset basis
+    const uint64_t hash_prime = 1099511628211ULL; // FNV-1a prime
+
+    /// Number of bytes between the starts of consecutive columns.
+    inline std::size_t stride(uint64_t nrow, uint32_t dtype) {
+      std::size_t nb = nrow * dtype;
+      return (nb + 63) / 64 * 64;
+    }
+
+    /// Header of a new column file.
+    inline ColHeader make_header(const std::vector<std::string>& names,
+                                 uint32_t dtype, uint64_t nrow,
+                                 int sort_col) {
+      if(names.empty() || names.size() > 8) {
+        throw std::invalid_argument("column file must have between 1 and 8 columns.");
+      }
+      if(dtype != 8 && dtype != 4) {
+        throw std::invalid_argument("dtype must be 8 (float64) or 4 (float32).");
+      }
+      ColHeader hdr;
+      std::memset(&hdr, 0, sizeof(hdr));
+      std::memcpy(hdr.magic, magic, sizeof(magic));
+      hdr.version = version;
+      hdr.dtype = dtype;
+      hdr.nrow = nrow;
+      hdr.ncol = names.size();
+      hdr.sort_col = sort_col;
+      hdr.flags = sort_col >= 0 ? sorted_flag : 0;
+      hdr.family = -1;
+      hdr.nu = 0.0;
+      hdr.source = 0;
+      for(std::size_t jj=0; jj<names.size(); jj++) {
+        std::strncpy(hdr.names[jj], names[jj].c_str(), 7);
+      }
+      return hdr;
+    }
+
+    /// Sequential writer of the columns of a column file.
+    ///
+    /// Values are appended to each column independently, and written to their positions in the file in blocks.
+    class ColSink {
+    private:
+      std::fstream out_;
+      ColHeader hdr_;
+      std::vector<std::vector<double> > buf_; // buffered values of each column
+      std::vector<uint64_t> nout_; // values written to each column
+      std::size_t bufsize_;
+      /// Write the buffer of column `j` to the file.
+      void flush(int j) {
+        std::vector<double>& b = buf_[j];
+        if(b.empty()) return;
+        if(nout_[j] + b.size() > hdr_.nrow) {
+          throw std::length_error("too many values written to column file.");
+        }
+        std::streamoff off = sizeof(ColHeader) +
+          j * stride(hdr_.nrow, hdr_.dtype) + nout_[j] * hdr_.dtype;
+        out_.seekp(off);
+        if(hdr_.dtype == 8) {
+          out_.write(reinterpret_cast<const char*>(b.data()),
+                     b.size() * sizeof(double));
+        } else {
+          std::vector<float> bf(b.begin(), b.end());
+          out_.write(reinterpret_cast<const char*>(bf.data()),
+                     bf.size() * sizeof(float));
+        }
+        if(!out_) throw std::runtime_error("error writing column file.");
+        nout_[j] += b.size();
+        b.clear();
+      }
+    public:
+      ColSink(const std::string& path, const ColHeader& hdr,
+              std::size_t bufsize = 1 << 16) :
+        hdr_(hdr), buf_(hdr.ncol), nout_(hdr.ncol, 0), bufsize_(bufsize) {
+        out_.open(path, std::ios::in | std::ios::out |
+                  std::ios::binary | std::ios::trunc);
+        if(!out_) throw std::runtime_error("cannot open file: " + path);
+        out_.write(reinterpret_cast<const char*>(&hdr_), sizeof(ColHeader));
+        for(auto& b : buf_) b.reserve(bufsize_);
+      }
+      /// Append a value to column `j`.
+      void push(int j, double val) {
+        buf_[j].push_back(val);
+        if(buf_[j].size() >= bufsize_) flush(j);
+      }
+      /// Flush all buffers and pad the file to its full size.
+      void close() {
+        for(std::size_t jj=0; jj<buf_.size(); jj++) flush(jj);
+        for(std::size_t jj=0; jj<nout_.size(); jj++) {
+          if(nout_[jj] != hdr_.nrow) {
+            throw std::length_error("too few values written to column file.");
+          }
+        }
+        std::size_t size = sizeof(ColHeader) +
+          hdr_.ncol * stride(hdr_.nrow, hdr_.dtype);
+        out_.seekp(0, std::ios::end);
+        std::size_t pos = out_.tellp();
+        if(pos < size) {
+          std::vector<char> zeros(size - pos, 0);
+          out_.write(zeros.data(), zeros.size());
+        }
+        out_.close();
+        if(out_.fail()) throw std::runtime_error("error writing column file.");
+      }
+    };
+
+  } // end namespace colfile
+
+  /// Read-only memory-mapped column file.
+  ///
+  /// On POSIX systems the file is mapped with `mmap()`, such that only the pages which are accessed are read from disk.  Elsewhere, the file is read into memory.
+  class ColFile {
+  private:
+    ColHeader hdr_;
+    const char* data_ = nullptr; // start of file
+    std::size_t size_ = 0; // file size in bytes
+#ifdef _WIN32
+    std::vector<double> buf_; // file contents (8-byte aligned)
+#endif
+    ColFile(const ColFile&) = delete;
+    ColFile& operator=(const ColFile&) = delete;
+    void unmap() {
+#ifndef _WIN32
+      if(data_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+      data_ = nullptr;
+    }
+    void check_col(int j) const {
+      if(j < 0 || j >= static_cast<int>(hdr_.ncol)) {
+        throw std::out_of_range("invalid column index.");
+      }
+    }
+  public:
+    /// Open a column file.
+    ///
+    /// @param[in] path Path of the file.
+    explicit ColFile(const std::string& path) {
+#ifndef _WIN32
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if(fd < 0) throw std::runtime_error("cannot open file: " + path);
+      struct stat st;
+      if(::fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(ColHeader)) {
+        ::close(fd);
+        throw std::runtime_error("not a column file: " + path);
+      }
+      size_ = st.st_size;
+      void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if(p == MAP_FAILED) throw std::runtime_error("cannot map file: " + path);
+      data_ = static_cast<const char*>(p);
+#else
+      std::ifstream in(path, std::ios::binary | std::ios::ate);
+      if(!in) throw std::runtime_error("cannot open file: " + path);
+      size_ = in.tellg();
+      if(size_ < sizeof(ColHeader)) {
+        throw std::runtime_error("not a column file: " + path);
+      }
+      buf_.resize((size_ + 7) / 8);
+      in.seekg(0);
+      in.read(reinterpret_cast<char*>(buf_.data()), size_);
+      data_ = reinterpret_cast<const char*>(buf_.data());
+#endif
+      std::memcpy(&hdr_, data_, sizeof(ColHeader));
+      bool valid = std::memcmp(hdr_.magic, colfile::magic, 8) == 0 &&
+        hdr_.version == colfile::version &&
+        (hdr_.dtype == 8 || hdr_.dtype == 4) &&
+        hdr_.ncol >= 1 && hdr_.ncol <= 8 &&
+        size_ >= sizeof(ColHeader) +
+        hdr_.ncol * colfile::stride(hdr_.nrow, hdr_.dtype);
+      if(!valid) {
+        unmap();
+        throw std::runtime_error("not a valid column file: " + path);
+      }
+    }
+
+    ~ColFile() {
+      unmap();
+    }
+
+    /// Check whether a file is a column file, without mapping it.
+    static bool is_colfile(const std::string& path) {
+      std::ifstream in(path, std::ios::binary);
+      char magic[8];
+      return in.read(magic, 8) && std::memcmp(magic, colfile::magic, 8) == 0;
+    }
+
+    /// File header.
+    const ColHeader& header() const {return hdr_;}
+    /// Number of rows.
+    int nrow() const {return static_cast<int>(hdr_.nrow);}
+    /// Number of columns.
+    int ncol() const {return hdr_.ncol;}
+    /// Whether the values are stored as `float64`.
+    bool is_double() const {return hdr_.dtype == 8;}
+    /// Whether the rows are sorted by column `sort_col`.
+    bool sorted() const {return (hdr_.flags & colfile::sorted_flag) != 0;}
+
+    /// Index of a named column, or -1 if there is none.
+    int col_index(const std::string& name) const {
+      for(int jj=0; jj<ncol(); jj++) {
+        if(name == std::string(hdr_.names[jj], strnlen(hdr_.names[jj], 8))) {
+          return jj;
+        }
+      }
+      return -1;
+    }
+
+    /// Column of a `float64` file, without copying.
+    Map<const VectorXd> column(int j) const {
+      return Map<const VectorXd>(col_data(j), nrow());
+    }
+
+    /// Contiguous columns `j, ..., j+nc-1` of a `float64` file as a matrix, without copying.
+    Map<const MatrixXd, 0, OuterStride<> > matrix(int j, int nc) const {
+      check_col(j + nc - 1);
+      OuterStride<> os(colfile::stride(hdr_.nrow, hdr_.dtype) / sizeof(double));
+      return Map<const MatrixXd, 0, OuterStride<> >(col_data(j), nrow(), nc, os);
+    }
+
+    /// Copy of the elements `start, ..., start+len-1` of a column of a file of either type.
+    VectorXd column_copy(int j, int start, int len) const {
+      if(start < 0 || len < 0 || start + len > nrow()) {
+        throw std::out_of_range("invalid row range.");
+      }
+      if(is_double()) return column(j).segment(start, len);
+      check_col(j);
+      const float* p = reinterpret_cast<const float*>(col_ptr(j)) + start;
+      return Map<const VectorXf>(p, len).cast<double>();
+    }
+
+    /// Copy of a column of a file of either type.
+    VectorXd column_copy(int j) const {
+      return column_copy(j, 0, nrow());
+    }
+
+    /// Copy of contiguous columns of a file of either type.
+    MatrixXd matrix_copy(int j, int nc) const {
+      MatrixXd out(nrow(), nc);
+      for(int jj=0; jj<nc; jj++) out.col(jj) = column_copy(j + jj);
+      return out;
+    }
+
+    /// Hash of the stored values of a column.
+    ///
+    /// FNV-1a over the bytes of the column, taken 8 at a time.  Hashes of several columns are combined by passing the hash of one as the `seed` of the next.
+    ///
+    /// @param[in] j Column index.
+    /// @param[in] seed Starting value of the hash.
+    uint64_t column_hash(int j, uint64_t seed = colfile::hash_seed) const {
+      check_col(j);
+      const char* p = col_ptr(j);
+      std::size_t nb = hdr_.nrow * hdr_.dtype;
+      uint64_t h = seed, w;
+      std::size_t ii = 0;
+      for(; ii+8<=nb; ii+=8) {
+        std::memcpy(&w, p + ii, 8);
+        h = (h ^ w) * colfile::hash_prime;
+      }
+      for(; ii<nb; ii++) {
+        h = (h ^ static_cast<unsigned char>(p[ii])) * colfile::hash_prime;
+      }
+      return h;
+    }
+
+  private:
+    const char* col_ptr(int j) const {
+      return data_ + sizeof(ColHeader) +
+        j * colfile::stride(hdr_.nrow, hdr_.dtype);
+    }
+    const double* col_data(int j) const {
+      check_col(j);
+      if(!is_double()) {
+        throw std::logic_error("zero-copy access requires a float64 column file.");
+      }
+      return reinterpret_cast<const double*>(col_ptr(j));
+    }
+  };
+
+  /// Streaming writer of column files with external sorting.
+  ///
+  /// Rows are appended in chunks of any size.  Every `chunk_rows` rows, the buffered rows are sorted by column `sort_col` and written to a temporary file (a run).  When the writer is finished, the runs are merged into the column file, such that at most `chunk_rows` rows are held in memory at any time.  Ties in the sorting column keep their original order.  If all rows fit in a single chunk, no temporary files are used.
+  class ColWriter {
+  private:
+    std::string path_; // output file
+    std::vector<std::string> names_; // column names
+    uint32_t dtype_; // bytes per value
+    int sort_col_; // sorting column
+    std::size_t chunk_rows_; // rows per run
+    std::string tmp_prefix_; // prefix of run files
+    std::vector<double> buf_; // row-major buffer of unsorted rows
+    std::vector<std::string> runs_; // run files
+    std::vector<uint64_t> run_rows_; // rows in each run
+    uint64_t nrow_ = 0; // total rows
+    bool finished_ = false;
+
+    int ncol() const {return names_.size();}
+
+    /// Sort the buffered rows, returning their order.
+    std::vector<std::size_t> sort_buffer() const {
+      std::size_t nb = buf_.size() / ncol();
+      std::vector<std::size_t> ix(nb);
+      std::iota(ix.begin(), ix.end(), 0);
+      if(sort_col_ >= 0) {
+        const double* b = buf_.data() + sort_col_;
+        int nc = ncol();
+        std::stable_sort(ix.begin(), ix.end(),
+                         [b, nc](std::size_t i, std::size_t j) {
+                           return b[i*nc] < b[j*nc];
+                         });
+      }
+      return ix;
+    }
+
+    /// Write the sorted buffer to a new run.
+    void spill() {
+      if(buf_.empty()) return;
+      std::vector<std::size_t> ix = sort_buffer();
+      std::string run = tmp_prefix_ + ".run" + std::to_string(runs_.size());
+      std::ofstream out(run, std::ios::binary);
+      if(!out) throw std::runtime_error("cannot open file: " + run);
+      int nc = ncol();
+      for(std::size_t ii : ix) {
+        out.write(reinterpret_cast<const char*>(buf_.data() + ii*nc),
+                  nc * sizeof(double));
+      }
+      if(!out) throw std::runtime_error("error writing file: " + run);
+      runs_.push_back(run);
+      run_rows_.push_back(ix.size());
+      buf_.clear();
+    }
+
+    void remove_runs() {
+      for(const auto& run : runs_) std::remove(run.c_str());
+      runs_.clear();
+    }
+
+    /// Buffered reader of the rows of a run.
+    struct RunReader {
+      std::ifstream in;
+      std::vector<double> buf;
+      std::size_t pos = 0, len = 0;
+      uint64_t left; // rows not yet read into buf
+      int nc;
+      RunReader(const std::string& run, uint64_t nrow, int nc,
+                std::size_t block) : in(run, std::ios::binary),
+                                     buf(block * nc), left(nrow), nc(nc) {
+        if(!in) throw std::runtime_error("cannot open file: " + run);
+      }
+      /// Current row, or `nullptr` when the run is exhausted.
+      const double* row() {
+        if(pos == len) {
+          std::size_t nr = std::min<uint64_t>(left, buf.size() / nc);
+          if(nr == 0) return nullptr;
+          in.read(reinterpret_cast<char*>(buf.data()), nr * nc * sizeof(double));
+          if(!in) throw std::runtime_error("error reading run file.");
+          left -= nr;
+          pos = 0;
+          len = nr;
+        }
+        return buf.data() + pos * nc;
+      }
+      void next() {pos++;}
+    };
+
+  public:
+    /// Constructor.
+    ///
+    /// @param[in] path Path of the column file.
+    /// @param[in] names Column names.
+    /// @param[in] sort_col Index of the column by which to sort the rows, or -1 to keep them in their original order.
+    /// @param[in] dtype Bytes per value: 8 for `float64` or 4 for `float32`.
+    /// @param[in] chunk_rows Maximum number of rows held in memory.
+    /// @param[in] tmpdir Directory for the temporary run files.  Defaults to the directory of `path`.
+    ColWriter(const std::string& path,
+              const std::vector<std::string>& names,
+              int sort_col, int dtype = 8,
+              std::size_t chunk_rows = 1 << 22,
+              const std::string& tmpdir = "") :
+      path_(path), names_(names), dtype_(dtype), sort_col_(sort_col),
+      chunk_rows_(std::max<std::size_t>(chunk_rows, 1)) {
+      // validate arguments
+      colfile::make_header(names_, dtype_, 0, sort_col_);
+      if(sort_col_ >= ncol()) {
+        throw std::invalid_argument("invalid sorting column.");
+      }
+      if(tmpdir.empty()) {
+        tmp_prefix_ = path_;
+      } else {
+        std::size_t sl = path_.find_last_of("/\\");
+        tmp_prefix_ = tmpdir + "/" +
+          (sl == std::string::npos ? path_ : path_.substr(sl + 1));
+      }
+    }
+
+    ~ColWriter() {
+      remove_runs();
+    }
+
+    /// Number of rows appended so far.
+    uint64_t nrow() const {return nrow_;}
+
+    /// Append rows.
+    ///
+    /// @param[in] rows Matrix with one row per observation and one column per column of the file.
+    void append(cRefMatrix_t<double>& rows) {
+      if(finished_) throw std::logic_error("column file is already finished.");
+      if(rows.cols() != ncol()) {
+        throw std::invalid_argument("rows must have one column per column of the file.");
+      }
+      for(int ii=0; ii<rows.rows(); ii++) {
+        if(sort_col_ >= 0 && std::isnan(rows(ii,sort_col_))) {
+          throw std::invalid_argument("missing values in the sorting column.");
+        }
+        for(int jj=0; jj<ncol(); jj++) buf_.push_back(rows(ii,jj));
+        nrow_++;
+        if(buf_.size() >= chunk_rows_ * ncol()) spill();
+      }
+    }
+
+    /// Sort the rows and write the column file.
+    void finish() {
+      if(finished_) return;
+      finished_ = true;
+      int nc = ncol();
+      ColHeader hdr = colfile::make_header(names_, dtype_, nrow_, sort_col_);
+      colfile::ColSink sink(path_, hdr);
+      if(runs_.empty()) {
+        // everything is in memory
+        std::vector<std::size_t> ix = sort_buffer();
+        for(int jj=0; jj<nc; jj++) {
+          for(std::size_t ii : ix) sink.push(jj, buf_[ii*nc + jj]);
+        }
+        buf_.clear();
+      } else {
+        spill();
+        // k-way merge, breaking ties by run index to keep the sort stable
+        std::size_t nrun = runs_.size();
+        std::size_t block = std::max<std::size_t>(chunk_rows_ / nrun, 1024);
+        std::vector<std::unique_ptr<RunReader> > reader;
+        for(std::size_t kk=0; kk<nrun; kk++) {
+          reader.emplace_back(new RunReader(runs_[kk], run_rows_[kk],
+                                            nc, block));
+        }
+        int sc = std::max(sort_col_, 0);
+        using Item = std::pair<double, std::size_t>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item> > heap;
+        for(std::size_t kk=0; kk<nrun; kk++) {
+          const double* r = reader[kk]->row();
+          if(r) heap.emplace(sort_col_ >= 0 ? r[sc] : 0.0, kk);
+        }
+        while(!heap.empty()) {
+          std::size_t kk = heap.top().second;
+          heap.pop();
+          const double* r = reader[kk]->row();
+          for(int jj=0; jj<nc; jj++) sink.push(jj, r[jj]);
+          reader[kk]->next();
+          r = reader[kk]->row();
+          if(r) heap.emplace(sort_col_ >= 0 ? r[sc] : 0.0, kk);
+        }
+        reader.clear();
+        remove_runs();
+      }
+      sink.close();
+    }
+  };
+
+  /// Write the marginal transformations of a dataset to a column file.
+  ///
+  /// The transformations are calculated in chunks, such that the dataset need not fit in memory.  The output file has `utrans_size(family)` columns and records `family`, `nu`, and the hash of columns `iu1` and `iu2` of `data` (see `ColFile::column_hash()`) in its header, so that it can be reused for subsequent fits on the same data.  Its rows are in the same order as those of `data`.
+  ///
+  /// @param[in] data Column file containing the uniform responses.
+  /// @param[in] iu1 Column index of the first uniform response.
+  /// @param[in] iu2 Column index of the second uniform response.
+  /// @param[in] family Copula family.
+  /// @param[in] nu Second copula parameter.
+  /// @param[in] path Path of the output file, which is always `float64`.
+  /// @param[in] chunk_rows Number of rows transformed at a time.
+  inline void write_utrans(const ColFile& data, int iu1, int iu2,
+                           int family, double nu, const std::string& path,
+                           int chunk_rows = 1 << 20) {
+    int n = data.nrow();
+    int nt = utrans_size(family);
+    std::vector<std::string> names;
+    for(int jj=0; jj<nt; jj++) names.push_back("t" + std::to_string(jj));
+    ColHeader hdr = colfile::make_header(names, 8, n, data.header().sort_col);
+    hdr.flags = data.header().flags;
+    hdr.family = family;
+    hdr.nu = nu;
+    hdr.source = data.column_hash(iu2, data.column_hash(iu1));
+    colfile::ColSink sink(path, hdr);
+    chunk_rows = std::max(chunk_rows, 1);
+    MatrixXd ut;
+    for(int i0=0; i0<n; i0+=chunk_rows) {
+      int nr = std::min(chunk_rows, n - i0);
+      VectorXd u1 = data.column_copy(iu1, i0, nr);
+      VectorXd u2 = data.column_copy(iu2, i0, nr);
+      ut.resize(nr, nt);
+      utrans(u1, u2, nu, family, ut);
+      for(int jj=0; jj<nt; jj++) {
+        for(int ii=0; ii<nr; ii++) sink.push(jj, ut(ii,jj));
+      }
+    }
+    sink.close();
+  }
+
+  /// Whether a column file of marginal transformations can be reused for a dataset.
+  ///
+  /// @param[in] cache Column file written by `write_utrans()`.
+  /// @param[in] data Column file containing the uniform responses.
+  /// @param[in] iu1 Column index of the first uniform response.
+  /// @param[in] iu2 Column index of the second uniform response.
+  /// @param[in] family Copula family.
+  /// @param[in] nu Second copula parameter.
+  ///
+  /// @return `true` if `cache` is a `float64` file with one row per row of `data` and one column per transformation of `family`, and its header matches `family`, `nu`, and the hash of columns `iu1` and `iu2` of `data`.  The latter rejects the transformations of other data with the same dimensions.
+  inline bool utrans_matches(const ColFile& cache, const ColFile& data,
+                             int iu1, int iu2, int family, double nu) {
+    const ColHeader& hdr = cache.header();
+    return cache.is_double() && cache.nrow() == data.nrow() &&
+      cache.ncol() == utrans_size(family) && hdr.family == family &&
+      hdr.nu == nu &&
+      hdr.source == data.column_hash(iu2, data.column_hash(iu1));
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_COLFILE_HPP
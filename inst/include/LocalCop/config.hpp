@@ -3,6 +3,16 @@
 
 #include <Eigen/Dense>
 
+// the standalone library is compiled outside of TMB
+#if defined(LOCALCOP_STANDALONE) && !defined(LOCALCOP_NO_TMB)
+#define LOCALCOP_NO_TMB
+#endif
+
+#ifdef LOCALCOP_NO_TMB
+// scalar TMB functions for compiling outside of TMB
+#include "rmath.hpp"
+#endif
+
 namespace LocalCop {
   /// Import namespaces inside namespace
   using namespace Eigen;
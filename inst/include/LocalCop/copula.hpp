@@ -0,0 +1,134 @@
+/// @file copula.hpp
+///
+/// @brief PDF, h-functions, and CDF of any supported copula family, evaluated at each of a set of observations.
+
+#ifndef LOCALCOP_COPULA_HPP
+#define LOCALCOP_COPULA_HPP
+
+// this is where RefVector_t etc. is defined
+#include "config.hpp"
+#include "family.hpp"
+
+namespace LocalCop {
+
+  /// Copula function to evaluate.
+  enum CopulaFun {
+    COP_PDF = 0, ///< Copula PDF.
+    COP_HFUN = 1, ///< Partial derivative of the copula CDF with respect to `u1`.
+    COP_HFUN2 = 2, ///< Partial derivative of the copula CDF with respect to `u2`.
+    COP_CDF = 3 ///< Copula CDF.
+  };
+
+  namespace family_fun {
+
+    template <class Type, int FUN>
+    struct CopulaVec {
+      typedef Vector_t<Type> result_type;
+      cRefVector_t<Type>& u1;
+      cRefVector_t<Type>& u2;
+      cRefVector_t<Type>& par;
+      cRefVector_t<Type>& nu;
+      int give_log;
+      template <template<class> class Family>
+      Vector_t<Type> operator()(FamilyTag<Family>) const {
+        typedef Family<Type> Copula;
+        int n = u1.size();
+        bool scalar_par = par.size() == 1;
+        bool scalar_nu = nu.size() == 1;
+        Vector_t<Type> ans(n);
+        for(int ii=0; ii<n; ii++) {
+          Type theta = Copula::theta_par(par(scalar_par ? 0 : ii));
+          Type nui = nu(scalar_nu ? 0 : ii);
+          if(FUN == COP_PDF) {
+            ans(ii) = Copula::dfun(u1(ii), u2(ii), theta, nui, give_log);
+          } else if(FUN == COP_HFUN) {
+            ans(ii) = Copula::hfun(u1(ii), u2(ii), theta, nui, give_log);
+          } else if(FUN == COP_HFUN2) {
+            ans(ii) = Copula::hfun2(u1(ii), u2(ii), theta, nui, give_log);
+          } else {
+            ans(ii) = Copula::pfun(u1(ii), u2(ii), theta, nui, give_log);
+          }
+        }
+        return ans;
+      }
+    };
+
+    template <class Type>
+    struct HinvVec {
+      typedef Vector_t<Type> result_type;
+      cRefVector_t<Type>& p;
+      cRefVector_t<Type>& u1;
+      cRefVector_t<Type>& par;
+      cRefVector_t<Type>& nu;
+      template <template<class> class Family>
+      Vector_t<Type> operator()(FamilyTag<Family>) const {
+        typedef Family<Type> Copula;
+        int n = u1.size();
+        bool scalar_par = par.size() == 1;
+        bool scalar_nu = nu.size() == 1;
+        Vector_t<Type> ans(n);
+        for(int ii=0; ii<n; ii++) {
+          Type theta = Copula::theta_par(par(scalar_par ? 0 : ii));
+          ans(ii) = Copula::hinv(p(ii), u1(ii), theta, nu(scalar_nu ? 0 : ii));
+        }
+        return ans;
+      }
+    };
+
+  } // end namespace family_fun
+
+  /// Copula PDF, h-function, or CDF.
+  ///
+  /// The family is selected once, after which the corresponding function of the family class is evaluated at each observation.  Rotated copulas are evaluated by reflecting `u1` and/or `u2` inside the family class.  See `Rotated`.
+  ///
+  /// @param[in] fun Which function to evaluate.  See `CopulaFun`.
+  /// @param[in] u1 Vector of first uniform variables.
+  /// @param[in] u2 Vector of second uniform variables.
+  /// @param[in] par Copula parameter, as in **VineCopula**.  Vector of length 1 or the same length as `u1`.
+  /// @param[in] nu Second copula parameter.  Vector of length 1 or the same length as `u1`.  Only used if `family = 2`.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  /// @param[in] give_log Whether or not to return on the log scale.
+  ///
+  /// @return Vector of the same length as `u1`.  If `valid_family(family)` is `false`, a vector of length zero.
+  template <class Type>
+  Vector_t<Type> copula_fun(CopulaFun fun,
+                            cRefVector_t<Type>& u1, cRefVector_t<Type>& u2,
+                            cRefVector_t<Type>& par, cRefVector_t<Type>& nu,
+                            int family, int give_log) {
+    if(fun == COP_PDF) {
+      family_fun::CopulaVec<Type, COP_PDF> f = {u1, u2, par, nu, give_log};
+      return dispatch_family(family, f);
+    } else if(fun == COP_HFUN) {
+      family_fun::CopulaVec<Type, COP_HFUN> f = {u1, u2, par, nu, give_log};
+      return dispatch_family(family, f);
+    } else if(fun == COP_HFUN2) {
+      family_fun::CopulaVec<Type, COP_HFUN2> f = {u1, u2, par, nu, give_log};
+      return dispatch_family(family, f);
+    } else {
+      family_fun::CopulaVec<Type, COP_CDF> f = {u1, u2, par, nu, give_log};
+      return dispatch_family(family, f);
+    }
+  }
+
+  /// Inverse of the copula h-function with respect to `u2`.
+  ///
+  /// Closed-form inverses are used for the Gaussian, Student-t, Clayton, and Frank copulas, and a safeguarded Newton method for the Gumbel copula.  See `hinvgumbel()`.  Unlike `copula_fun()`, this is not meant to be used with **TMB** AD types.
+  ///
+  /// @param[in] p Vector of probabilities.
+  /// @param[in] u1 Vector of first uniform variables of the same length as `p`.
+  /// @param[in] par Copula parameter, as in **VineCopula**.  Vector of length 1 or the same length as `u1`.
+  /// @param[in] nu Second copula parameter.  Vector of length 1 or the same length as `u1`.  Only used if `family = 2`.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  ///
+  /// @return Vector of values of `u2` such that the h-function at `(u1, u2)` is `p`.  If `valid_family(family)` is `false`, a vector of length zero.
+  template <class Type>
+  Vector_t<Type> copula_hinv(cRefVector_t<Type>& p, cRefVector_t<Type>& u1,
+                             cRefVector_t<Type>& par, cRefVector_t<Type>& nu,
+                             int family) {
+    family_fun::HinvVec<Type> f = {p, u1, par, nu};
+    return dispatch_family(family, f);
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_COPULA_HPP
@@ -0,0 +1,413 @@
+/// @file family.hpp
+///
+/// @brief Copula family classes with a common interface.
+///
+/// Each copula family is a class template `Family<Type>` with the following static members:
+///
+/// - `family`: Integer code of the family.  See `ConvertPar()`.
+/// - `n_trans`: Number of marginal transformations.  See `utrans()`.
+/// - `has_pfun`: Whether the copula CDF is available.
+/// - `theta(eta)`: Copula parameter as a function of the calibration parameter `eta`.  See `BiCopEta2Par()`.
+/// - `theta_par(par)`: Copula parameter as a function of the **VineCopula** parameter `par`.
+/// - `tau(theta)`: Kendall's tau as a function of the copula parameter.  See `BiCopEta2Tau()`.
+/// - `utrans(u1, u2, nu, v)`: Marginal transformations of `u1` and `u2`, stored in the array `v` of length `n_trans`.
+/// - `lpdf_utrans(v, theta, nu)`: Copula log-density in terms of the marginal transformations.
+/// - `dfun(u1, u2, theta, nu, give_log)`: Copula PDF.
+/// - `hfun(u1, u2, theta, nu, give_log)`: Partial derivative of the copula CDF with respect to `u1`.
+/// - `hfun2(u1, u2, theta, nu, give_log)`: Partial derivative of the copula CDF with respect to `u2`.  This is `hfun(u2, u1, theta, nu, give_log)` for the exchangeable copulas, but not for the 90 and 270 degree rotations.
+/// - `pfun(u1, u2, theta, nu, give_log)`: Copula CDF.
+/// - `hinv(p, u1, theta, nu)`: Inverse of `hfun` with respect to `u2`, i.e., the value of `u2` such that `hfun(u1, u2, theta, nu) = p`.
+///
+/// The argument `nu` is the second copula parameter, which is only used by the Student-t copula.  Templates of the likelihood functions are instantiated once per family, such that the family code is only examined once by `dispatch_family()` rather than at every observation.
+
+#ifndef LOCALCOP_FAMILY_HPP
+#define LOCALCOP_FAMILY_HPP
+
+// this is where RefVector_t etc. is defined
+#include "config.hpp"
+#include "gaussian.hpp"
+#include "student.hpp"
+#include "clayton.hpp"
+#include "gumbel.hpp"
+#include "frank.hpp"
+
+namespace LocalCop {
+
+  /// Gaussian copula with parameter `theta = tanh(eta)`.
+  template <class Type>
+  class Gaussian {
+  public:
+    static const int family = 1;
+    static const int n_trans = 2;
+    static const bool has_pfun = true;
+    static Type theta(Type eta) {
+      Type ans = exp(Type(2.0) * eta);
+      return (ans - Type(1.0)) / (ans + Type(1.0));
+    }
+    static Type theta_par(Type par) {
+      return par;
+    }
+    /// Kendall's tau `2/pi * asin(theta)`.
+    static Type tau(Type theta) {
+      return Type(2.0 / M_PI) * asin(theta);
+    }
+    /// Marginal transformations `qnorm(u1)`, `qnorm(u2)`.
+    static void utrans(Type u1, Type u2, Type /* nu */, Type* v) {
+      v[0] = qnorm(u1);
+      v[1] = qnorm(u2);
+    }
+    static Type lpdf_utrans(const Type* v, Type theta, Type /* nu */) {
+      return dgaussian_z(v[0], v[1], theta, 1);
+    }
+    static Type dfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return dgaussian(u1, u2, theta, give_log);
+    }
+    static Type hfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return hgaussian(u1, u2, theta, give_log);
+    }
+    static Type hfun2(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      return hfun(u2, u1, theta, nu, give_log);
+    }
+    static Type pfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return pgaussian(u1, u2, theta, give_log);
+    }
+    static Type hinv(Type p, Type u1, Type theta, Type /* nu */) {
+      return hinvgaussian(p, u1, theta);
+    }
+  };
+
+  /// Student-t copula with parameter `theta = tanh(eta)`.
+  template <class Type>
+  class Student {
+  public:
+    static const int family = 2;
+    static const int n_trans = 3;
+    static const bool has_pfun = true;
+    static Type theta(Type eta) {
+      return Gaussian<Type>::theta(eta);
+    }
+    static Type theta_par(Type par) {
+      return par;
+    }
+    static Type tau(Type theta) {
+      return Gaussian<Type>::tau(theta);
+    }
+    /// Marginal transformations `y1 = qt(u1, nu)`, `y2 = qt(u2, nu)`, and `dt(y1, nu, 1) + dt(y2, nu, 1)`.
+    static void utrans(Type u1, Type u2, Type nu, Type* v) {
+      v[0] = qt(u1, nu);
+      v[1] = qt(u2, nu);
+      v[2] = dt(v[0], nu, 1) + dt(v[1], nu, 1);
+    }
+    static Type lpdf_utrans(const Type* v, Type theta, Type nu) {
+      return dstudent_t(v[0], v[1], v[2], theta, nu, 1);
+    }
+    static Type dfun(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      return dstudent(u1, u2, theta, nu, give_log);
+    }
+    static Type hfun(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      return hstudent(u1, u2, theta, nu, give_log);
+    }
+    static Type hfun2(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      return hfun(u2, u1, theta, nu, give_log);
+    }
+    static Type pfun(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      return pstudent(u1, u2, theta, nu, give_log);
+    }
+    static Type hinv(Type p, Type u1, Type theta, Type nu) {
+      return hinvstudent(p, u1, theta, nu);
+    }
+  };
+
+  /// Clayton copula with parameter `theta = exp(eta)`.
+  template <class Type>
+  class Clayton {
+  public:
+    static const int family = 3;
+    static const int n_trans = 2;
+    static const bool has_pfun = true;
+    static Type theta(Type eta) {
+      return exp(eta);
+    }
+    static Type theta_par(Type par) {
+      return par;
+    }
+    /// Kendall's tau `theta / (theta + 2)`.
+    static Type tau(Type theta) {
+      return theta / (theta + Type(2.0));
+    }
+    /// Marginal transformations `log(u1)`, `log(u2)`.
+    static void utrans(Type u1, Type u2, Type /* nu */, Type* v) {
+      v[0] = log(u1);
+      v[1] = log(u2);
+    }
+    static Type lpdf_utrans(const Type* v, Type theta, Type /* nu */) {
+      return dclayton_log(v[0], v[1], theta, 1);
+    }
+    static Type dfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return dclayton(u1, u2, theta, give_log);
+    }
+    static Type hfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return hclayton(u1, u2, theta, give_log);
+    }
+    static Type hfun2(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      return hfun(u2, u1, theta, nu, give_log);
+    }
+    static Type pfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return pclayton(u1, u2, theta, give_log);
+    }
+    static Type hinv(Type p, Type u1, Type theta, Type /* nu */) {
+      return hinvclayton(p, u1, theta);
+    }
+  };
+
+  /// Gumbel copula with parameter `theta = 1 + exp(eta)`.
+  template <class Type>
+  class Gumbel {
+  public:
+    static const int family = 4;
+    static const int n_trans = 4;
+    static const bool has_pfun = true;
+    static Type theta(Type eta) {
+      return Type(1.0) + exp(eta);
+    }
+    static Type theta_par(Type par) {
+      return par;
+    }
+    /// Kendall's tau `1 - 1/theta`.
+    static Type tau(Type theta) {
+      return Type(1.0) - Type(1.0) / theta;
+    }
+    /// Marginal transformations `log(u1)`, `log(u2)`, `log(-log(u1))`, `log(-log(u2))`.
+    static void utrans(Type u1, Type u2, Type /* nu */, Type* v) {
+      v[0] = log(u1);
+      v[1] = log(u2);
+      v[2] = log(-v[0]);
+      v[3] = log(-v[1]);
+    }
+    static Type lpdf_utrans(const Type* v, Type theta, Type /* nu */) {
+      return dgumbel_log(v[0], v[1], v[2], v[3], theta, 1);
+    }
+    static Type dfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return dgumbel(u1, u2, theta, give_log);
+    }
+    static Type hfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return hgumbel(u1, u2, theta, give_log);
+    }
+    static Type hfun2(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      return hfun(u2, u1, theta, nu, give_log);
+    }
+    static Type pfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return pgumbel(u1, u2, theta, give_log);
+    }
+    static Type hinv(Type p, Type u1, Type theta, Type /* nu */) {
+      return hinvgumbel(p, u1, theta);
+    }
+  };
+
+  /// Frank copula with parameter `theta = eta`.
+  template <class Type>
+  class Frank {
+  public:
+    static const int family = 5;
+    static const int n_trans = 2;
+    static const bool has_pfun = true;
+    static Type theta(Type eta) {
+      return eta;
+    }
+    static Type theta_par(Type par) {
+      return par;
+    }
+    static Type tau(Type theta) {
+      return tfrank(theta);
+    }
+    /// Marginal transformations `u1`, `u2`.
+    static void utrans(Type u1, Type u2, Type /* nu */, Type* v) {
+      v[0] = u1;
+      v[1] = u2;
+    }
+    static Type lpdf_utrans(const Type* v, Type theta, Type /* nu */) {
+      return dfrank(v[0], v[1], theta, 1);
+    }
+    static Type dfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return dfrank(u1, u2, theta, give_log);
+    }
+    static Type hfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return hfrank(u1, u2, theta, give_log);
+    }
+    static Type hfun2(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      return hfun(u2, u1, theta, nu, give_log);
+    }
+    static Type pfun(Type u1, Type u2, Type theta, Type /* nu */, int give_log) {
+      return pfrank(u1, u2, theta, give_log);
+    }
+    static Type hinv(Type p, Type u1, Type theta, Type /* nu */) {
+      return hinvfrank(p, u1, theta);
+    }
+  };
+
+  /// Rotated copula.
+  ///
+  /// With `C0(u1, u2)` the CDF of the `Base` copula, the rotated copula CDF is
+  ///
+  /// - `ROT = 1` (180 degrees): `C(u1, u2) = u1 + u2 - 1 + C0(1-u1, 1-u2)`.
+  /// - `ROT = 2` (90 degrees): `C(u1, u2) = u2 - C0(1-u1, u2)`.
+  /// - `ROT = 3` (270 degrees): `C(u1, u2) = u1 - C0(u1, 1-u2)`.
+  ///
+  /// such that the family code is `10 * ROT + Base<Type>::family`.  The parameter `theta` is that of the `Base` copula, i.e., it is the negative of the **VineCopula** parameter for the 90 and 270 degree rotations.
+  template <class Type, template<class> class Base, int ROT>
+  class Rotated {
+  private:
+    typedef Base<Type> Base_t;
+    /// Reflect `u1` and/or `u2`.
+    static void rotate(Type& u1, Type& u2) {
+      if(ROT != 3) u1 = Type(1.0) - u1;
+      if(ROT != 2) u2 = Type(1.0) - u2;
+    }
+  public:
+    static const int family = 10 * ROT + Base_t::family;
+    static const int n_trans = Base_t::n_trans;
+    static const bool has_pfun = Base_t::has_pfun;
+    static Type theta(Type eta) {
+      return Base_t::theta(eta);
+    }
+    /// The **VineCopula** parameter of the 90 and 270 degree rotations is negative.
+    static Type theta_par(Type par) {
+      if(ROT == 1) return par; else return -par;
+    }
+    /// Kendall's tau is negated by the 90 and 270 degree rotations.
+    static Type tau(Type theta) {
+      Type ans = Base_t::tau(theta);
+      if(ROT == 1) return ans; else return -ans;
+    }
+    /// Marginal transformations of the `Base` copula after rotating `u1` and `u2`.
+    static void utrans(Type u1, Type u2, Type nu, Type* v) {
+      rotate(u1, u2);
+      Base_t::utrans(u1, u2, nu, v);
+    }
+    static Type lpdf_utrans(const Type* v, Type theta, Type nu) {
+      return Base_t::lpdf_utrans(v, theta, nu);
+    }
+    static Type dfun(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      rotate(u1, u2);
+      return Base_t::dfun(u1, u2, theta, nu, give_log);
+    }
+    static Type hfun(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      rotate(u1, u2);
+      Type ans = Base_t::hfun(u1, u2, theta, nu, 0);
+      if(ROT != 2) ans = Type(1.0) - ans;
+      if(give_log) return log(ans); else return ans;
+    }
+    static Type hfun2(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      rotate(u1, u2);
+      Type ans = Base_t::hfun2(u1, u2, theta, nu, 0);
+      if(ROT != 3) ans = Type(1.0) - ans;
+      if(give_log) return log(ans); else return ans;
+    }
+    /// Inverse of `hfun`, obtained by reflecting `u1` and `p` and/or the result.
+    static Type hinv(Type p, Type u1, Type theta, Type nu) {
+      if(ROT == 1) {
+        return Type(1.0) - Base_t::hinv(Type(1.0) - p, Type(1.0) - u1, theta, nu);
+      } else if(ROT == 2) {
+        return Base_t::hinv(p, Type(1.0) - u1, theta, nu);
+      } else {
+        return Type(1.0) - Base_t::hinv(Type(1.0) - p, u1, theta, nu);
+      }
+    }
+    static Type pfun(Type u1, Type u2, Type theta, Type nu, int give_log) {
+      Type v1 = u1;
+      Type v2 = u2;
+      rotate(v1, v2);
+      Type ans = Base_t::pfun(v1, v2, theta, nu, 0);
+      if(ROT == 1) {
+        ans = u1 + u2 - Type(1.0) + ans;
+      } else if(ROT == 2) {
+        ans = u2 - ans;
+      } else {
+        ans = u1 - ans;
+      }
+      if(give_log) return log(ans); else return ans;
+    }
+  };
+
+  /// Clayton copula rotated by 180 degrees (family 13).
+  template <class Type>
+  using Clayton180 = Rotated<Type, Clayton, 1>;
+  /// Gumbel copula rotated by 180 degrees (family 14).
+  template <class Type>
+  using Gumbel180 = Rotated<Type, Gumbel, 1>;
+  /// Clayton copula rotated by 90 degrees (family 23).
+  template <class Type>
+  using Clayton90 = Rotated<Type, Clayton, 2>;
+  /// Gumbel copula rotated by 90 degrees (family 24).
+  template <class Type>
+  using Gumbel90 = Rotated<Type, Gumbel, 2>;
+  /// Clayton copula rotated by 270 degrees (family 33).
+  template <class Type>
+  using Clayton270 = Rotated<Type, Clayton, 3>;
+  /// Gumbel copula rotated by 270 degrees (family 34).
+  template <class Type>
+  using Gumbel270 = Rotated<Type, Gumbel, 3>;
+
+  /// Tag type for passing a family class template to a function object.
+  template <template<class> class Family>
+  struct FamilyTag {};
+
+  /// Whether the family code is supported by `dispatch_family()`.
+  inline bool valid_family(int family) {
+    switch(family) {
+    case 1: case 2: case 3: case 4: case 5:
+    case 13: case 14: case 23: case 24: case 33: case 34:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /// Call a function object with the family class corresponding to a family code.
+  ///
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  /// @param[in] fun Function object with a member type `result_type` and a member function template
+  /// ```
+  /// template <template<class> class Family>
+  /// result_type operator()(FamilyTag<Family>) const;
+  /// ```
+  ///
+  /// @return The value of `fun(FamilyTag<Family>())` for the class template `Family` corresponding to `family`.  If `valid_family(family)` is `false`, returns `result_type()` without calling `fun`.
+  template <class Fun>
+  typename Fun::result_type dispatch_family(int family, const Fun& fun) {
+    switch(family) {
+    case 1: return fun(FamilyTag<Gaussian>());
+    case 2: return fun(FamilyTag<Student>());
+    case 3: return fun(FamilyTag<Clayton>());
+    case 4: return fun(FamilyTag<Gumbel>());
+    case 5: return fun(FamilyTag<Frank>());
+    case 13: return fun(FamilyTag<Clayton180>());
+    case 14: return fun(FamilyTag<Gumbel180>());
+    case 23: return fun(FamilyTag<Clayton90>());
+    case 24: return fun(FamilyTag<Gumbel90>());
+    case 33: return fun(FamilyTag<Clayton270>());
+    case 34: return fun(FamilyTag<Gumbel270>());
+    default: return typename Fun::result_type();
+    }
+  }
+
+  namespace family_fun {
+
+    struct HasPfun {
+      typedef bool result_type;
+      template <template<class> class Family>
+      bool operator()(FamilyTag<Family>) const {
+        return Family<double>::has_pfun;
+      }
+    };
+
+  } // end namespace family_fun
+
+  /// Whether the copula CDF of a family is available.
+  inline bool has_pcopula(int family) {
+    return dispatch_family(family, family_fun::HasPfun());
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_FAMILY_HPP
@@ -0,0 +1,214 @@
+/// @file fitgrid.hpp
+///
+/// @brief Local likelihood fits over a grid of covariate values, in parallel.
+
+#ifndef LOCALCOP_FITGRID_HPP
+#define LOCALCOP_FITGRID_HPP
+
+#include "locfit.hpp"
+#include "threads.hpp"
+#include <vector>
+#include <stdexcept>
+
+namespace LocalCop {
+
+  /// Control parameters of `fit_grid()`.
+  struct GridControl {
+    /// If `true`, the starting value at each `x0` after the first is extrapolated from the previous estimate, i.e., `beta[0] + beta[1] * (x0[i] - x0[i-1])` and the remaining coefficients of the previous estimate, unless the previous fit failed to converge.  With several covariates, `beta[0]` is extrapolated along each of them with the coefficients of the linear terms.
+    bool warm_start = false;
+    /// Maximum number of Newton iterations per element of `x0`.
+    int maxit = 100;
+    /// Relative tolerance of the Newton iterations.
+    double reltol = 1e-10;
+    /// If positive, each fit with `drop[i] >= 0` is calculated by first fitting the local likelihood with all observations, then leaving out observation `drop[i]` with at most `loo_steps` Newton steps of `LocalFit::downdate()`, which do not revisit the other observations.  The full-data fits do not depend on `drop`, so each is continued from the previous one in its block as with `warm_start`.  Otherwise, the fit without `drop[i]` is calculated directly.
+    int loo_steps = 0;
+    /// Whether to use closed-form derivatives of the log-density where available.  See `LocalFit::set_analytic()`.
+    bool analytic = true;
+    /// Number of threads.  See `get_nthreads()`.
+    int nthreads = 1;
+    /// Bandwidth type, with which `band` is either the bandwidth or the fraction of observations with positive weight.  See `LocalFit::set_band_type()`.
+    BandType band_type = BandType::Constant;
+  };
+
+  /// Output of `fit_grid()`.
+  struct GridFit {
+    /// A `npar x nx` matrix of local likelihood estimates of `beta`, where `npar = max(2, locpoly_size(ncol(x), degree))`.  Rows beyond the number of coefficients are zero, such that with a single covariate and `degree = 0` the second row is zero.
+    MatrixXd coef;
+    /// A `npar x nx` matrix of standard errors.
+    MatrixXd se;
+    /// A `npar^2 x nx` matrix, each column of which is the vectorized Hessian of the negative local log-likelihood.
+    MatrixXd hessian;
+    /// The value of the negative local log-likelihood at each fit.
+    VectorXd nll;
+    /// Convergence code at each fit.  See `LocalFit::fit()`.
+    std::vector<int> convergence;
+    /// Number of Newton iterations at each fit.
+    std::vector<int> niter;
+  };
+
+  /// Fit the local likelihood at each element of `x0`.
+  ///
+  /// The elements of `x0` are divided into contiguous blocks which are distributed dynamically over the threads by `parallel_for()`, each of which has its own `LocalFit` object sharing the data read-only.  Without warm starts or downdating each block is a single element of `x0`, and otherwise there are about four blocks per thread, within which the fits are continued from one element to the next.
+  ///
+  /// @param[in] utrans Matrix of marginal transformations of the uniform responses, with one row per observation and `utrans_size(family)` columns.  See `utrans()`.
+  /// @param[in] x Matrix of covariates, with one row per observation and between one and three columns, or a vector for a single covariate.
+  /// @param[in] x0 Matrix of covariate values at which to fit the local likelihood, with one row per fit and the same number of columns as `x`.
+  /// @param[in] drop Vector of length `nrow(x0)` giving the (0-based) index of the observation to leave out of each fit, with negative values for none.  Can also be empty, in which case all observations are used in every fit.  Leave-one-out fits are obtained with `x0 = x[xind]` and `drop = xind`.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  /// @param[in] nu Second copula parameter.
+  /// @param[in] degree Total degree of the local polynomial.  See `LocalFit`.
+  /// @param[in] kernel Kernel function.
+  /// @param[in] band Kernel bandwidth, or fraction of observations if `ctrl.band_type` is `BandType::Variable`.  Either a single value for all covariates, or one per covariate.  See `LocalFit::set_band()`.
+  /// @param[in] eta Matrix with `npar` rows giving the starting value of `beta` (see `GridFit::coef`).  Either a single column used at each `x0`, or one column per element of `x0`.
+  /// @param[in] ctrl Control parameters.
+  /// @param[out] out Local likelihood fits.
+  /// @param[in] freq Optional frequency weights of the rows of `utrans`.  See `LocalFit::set_freq()`.
+  inline void fit_grid(cRefMatrix_t<double>& utrans,
+                       cRefMatrix_t<double>& x,
+                       cRefMatrix_t<double>& x0,
+                       const std::vector<int>& drop,
+                       int family, double nu, int degree,
+                       Kernel kernel, cRefVector_t<double>& band,
+                       cRefMatrix_t<double>& eta,
+                       const GridControl& ctrl, GridFit& out,
+                       const double* freq = nullptr) {
+    int nx = x0.rows();
+    int ncov = x.cols();
+    int npar = locpoly_size(ncov, degree);
+    int nrow = std::max(2, npar);
+    if(x0.cols() != ncov) {
+      throw std::invalid_argument("x0 must have the same number of columns as x.");
+    }
+    if(drop.size() != 0 && static_cast<int>(drop.size()) != nx) {
+      throw std::invalid_argument("drop must have length 0 or length(x0).");
+    }
+    if(eta.rows() != nrow || (eta.cols() != 1 && eta.cols() != nx)) {
+      throw std::invalid_argument("eta must have one row per coefficient and either 1 or length(x0) columns.");
+    }
+    if(utrans.rows() != x.rows() || utrans.cols() != utrans_size(family)) {
+      throw std::invalid_argument("utrans must have length(x) rows and the number of columns required by family.");
+    }
+    if(nx == 0) {
+      // nothing to fit
+      out.coef.resize(nrow, 0);
+      out.se.resize(nrow, 0);
+      out.hessian.resize(nrow * nrow, 0);
+      out.nll.resize(0);
+      out.convergence.clear();
+      out.niter.clear();
+      return;
+    }
+    std::vector<int> idrop(nx, -1);
+    if(drop.size() != 0) std::copy(drop.begin(), drop.end(), idrop.begin());
+    // contiguous blocks of x0
+    bool warm_start = ctrl.warm_start;
+    bool downdate = ctrl.loo_steps > 0;
+    int nthreads = get_nthreads(ctrl.nthreads, nx);
+    int nblock = (warm_start || downdate) ? std::min(nx, 4 * nthreads) : nx;
+    if(nthreads == 1) nblock = std::min(nx, 1);
+    std::vector<int> block_start(nblock + 1);
+    for(int ib=0; ib<=nblock; ib++) {
+      block_start[ib] = static_cast<int>((static_cast<long>(nx) * ib) / nblock);
+    }
+    // one fitting object per thread
+    std::vector<LocalFit> locfit;
+    locfit.reserve(nthreads);
+    for(int it=0; it<nthreads; it++) {
+      locfit.emplace_back(utrans, x, family, nu, degree, kernel, band(0));
+      locfit[it].set_control(ctrl.maxit, ctrl.reltol);
+      locfit[it].set_analytic(ctrl.analytic);
+      locfit[it].set_freq(freq);
+      locfit[it].set_band_type(ctrl.band_type);
+      locfit[it].set_band(band);
+    }
+    // output
+    MatrixXd& coef = out.coef;
+    coef.resize(nrow, nx);
+    out.se = MatrixXd::Zero(nrow, nx);
+    out.hessian = MatrixXd::Zero(nrow * nrow, nx);
+    out.nll.resize(nx);
+    std::vector<int>& code = out.convergence;
+    std::vector<int>& niter = out.niter;
+    code.assign(nx, 0);
+    niter.assign(nx, 0);
+    parallel_for(nblock, nthreads, [&](int ib, int it) {
+      LocalFit& lf = locfit[it];
+      MatrixXd H(npar, npar);
+      VectorXd xi(ncov);
+      VectorXd beta_all(nrow); // last full-data fit for downdating
+      int code_all = -1;
+      for(int ii=block_start[ib]; ii<block_start[ib+1]; ii++) {
+        xi = x0.row(ii).transpose();
+        if(downdate && idrop[ii] >= 0) {
+          // full-data fit, continued from the previous one, then downdated
+          lf.set_x0(xi);
+          if(code_all == 0) {
+            for(int kk=0; kk<ncov && npar>1; kk++) {
+              beta_all(0) += beta_all(kk+1) * (x0(ii,kk) - x0(ii-1,kk));
+            }
+          } else {
+            beta_all = eta.col(eta.cols() == 1 ? 0 : ii);
+          }
+          code_all = lf.fit(beta_all);
+          int niter_all = lf.niter();
+          coef.col(ii) = beta_all;
+          // the first Newton step is free, and the others are exact
+          code[ii] = lf.downdate(idrop[ii], coef.col(ii), 1);
+          niter[ii] = niter_all + lf.niter();
+          if(code[ii] != 2 && ctrl.loo_steps > 1) {
+            lf.set_control(ctrl.loo_steps - 1, ctrl.reltol);
+            code[ii] = lf.fit(coef.col(ii));
+            lf.set_control(ctrl.maxit, ctrl.reltol);
+            niter[ii] += lf.niter();
+          }
+          // running out of downdating steps is not a failure,
+          // but leaving out the only observation is
+          if(code[ii] != 4 && (code_all != 0 || code[ii] == 1)) {
+            code[ii] = code_all;
+          }
+        } else {
+          code_all = -1;
+          if(warm_start && ii > block_start[ib] && code[ii-1] == 0) {
+            // continuation from previous fit
+            coef.col(ii) = coef.col(ii-1);
+            for(int kk=0; kk<ncov && npar>1; kk++) {
+              coef(0,ii) += coef(kk+1,ii-1) * (x0(ii,kk) - x0(ii-1,kk));
+            }
+          } else {
+            coef.col(ii) = eta.col(eta.cols() == 1 ? 0 : ii);
+          }
+          lf.set_x0(xi, idrop[ii]);
+          code[ii] = lf.fit(coef.col(ii));
+          niter[ii] = lf.niter();
+        }
+        out.nll(ii) = lf.nll();
+        lf.hessian(H);
+        Map<MatrixXd>(out.hessian.col(ii).data(), nrow, nrow).topLeftCorner(npar, npar) = H;
+        lf.std_err(out.se.col(ii).head(npar));
+      }
+    });
+    return;
+  }
+
+  /// Fit the local likelihood at each element of `x0` with the same bandwidth for every covariate.
+  ///
+  /// Same as the overload above, for the other arguments of which see there.
+  ///
+  /// @param[in] band Kernel bandwidth, or fraction of observations if `ctrl.band_type` is `BandType::Variable`.
+  inline void fit_grid(cRefMatrix_t<double>& utrans,
+                       cRefMatrix_t<double>& x,
+                       cRefMatrix_t<double>& x0,
+                       const std::vector<int>& drop,
+                       int family, double nu, int degree,
+                       Kernel kernel, double band,
+                       cRefMatrix_t<double>& eta,
+                       const GridControl& ctrl, GridFit& out,
+                       const double* freq = nullptr) {
+    fit_grid(utrans, x, x0, drop, family, nu, degree, kernel,
+             VectorXd::Constant(1, band), eta, ctrl, out, freq);
+    return;
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_FITGRID_HPP
@@ -5,6 +5,7 @@
 
 // this is where RefVector_t etc. is defined
 #include "config.hpp"
+#include "quadrature.hpp"
 
 namespace LocalCop {
 
@@ -43,6 +44,21 @@ namespace LocalCop {
     if(give_log) return log(ans); else return ans;
   }
   VECTORIZE4_ttti(hfrank)
+
+  /// Calculate the inverse of the Frank copula h-function with respect to u2.
+  ///
+  /// This is `u2 = -log(1 + p * (exp(-theta) - 1) / (p + (1-p) * exp(-theta * u1))) / theta`.
+  ///
+  /// @param[in] p Probability.
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] theta Parameter of the Frank copula with the range $R \setminus \{0\}$.
+  ///
+  /// @return Value of `u2` such that `hfrank(u1, u2, theta) = p`.
+  template <class Type>
+  Type hinvfrank(Type p, Type u1, Type theta) {
+    Type ans = p * expm1(-theta) / (p + (Type(1.0) - p) * exp(-theta * u1));
+    return -log1p(ans) / theta;
+  }
       
   /// Calculate Frank copula PDF.
   ///
@@ -65,6 +81,73 @@ namespace LocalCop {
   }
   VECTORIZE4_ttti(dfrank)
 
+  /// Calculate Frank copula log-PDF and its derivatives with respect to its parameter.
+  ///
+  /// The calibration scale for the Frank copula is the identity, `theta = eta`.  With `e_i = exp(-theta u_i)` and `N = exp(-theta) - 1 + (e1 - 1)(e2 - 1)`, the log-PDF is
+  ///
+  /// ```
+  /// log|theta| + log|exp(-theta) - 1| - theta (u1 + u2) - 2 log|N|,
+  /// ```
+  ///
+  /// the derivatives of which are calculated in closed form.
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] theta Parameter of the Frank copula with the range $R \setminus \{0\}$.
+  /// @param[out] d1 First derivative of the log-PDF with respect to `theta`.
+  /// @param[out] d2 Second derivative of the log-PDF with respect to `theta`.
+  ///
+  /// @return Value of the copula log-PDF.
+  template <class Type>
+  Type dfrank_eta(Type u1, Type u2, Type theta, Type& d1, Type& d2) {
+    Type e1 = exp(-theta*u1);
+    Type e2 = exp(-theta*u2);
+    Type e0 = exp(-theta);
+    Type term3 = e0 - Type(1.0);
+    Type N = term3 + (e1 - Type(1.0)) * (e2 - Type(1.0));
+    // derivatives of N with respect to theta
+    Type N1 = -e0 - u1 * e1 * (e2 - Type(1.0)) - u2 * e2 * (e1 - Type(1.0));
+    Type N2 = e0 + u1 * u1 * e1 * (e2 - Type(1.0)) +
+      u2 * u2 * e2 * (e1 - Type(1.0)) + Type(2.0) * u1 * u2 * e1 * e2;
+    N1 /= N;
+    N2 /= N;
+    Type itheta = Type(1.0) / theta;
+    Type iterm3 = Type(1.0) / term3;
+    d1 = itheta - e0 * iterm3 - (u1 + u2) - Type(2.0) * N1;
+    d2 = -itheta * itheta - e0 * iterm3 * iterm3 - Type(2.0) * (N2 - N1 * N1);
+    return log(-theta * term3 * e1 * e2 / (N * N));
+  }
+
+  /// Calculate Kendall's tau of the Frank copula.
+  ///
+  /// This is `tau = 1 - 4/theta * (1 - D1(theta))`, where `D1(theta) = 1/theta * int_0^theta t/(exp(t)-1) dt` is the Debye function of order one.  Since `tau` is an odd function of `theta`, it is calculated for `a = abs(theta)`.  The integral is calculated with the 20-point Gauss-Legendre rule for `a <= 5`, and otherwise as `pi^2/6` minus its upper tail `sum_k exp(-k a) (a/k + 1/k^2)`.  For `a < 1e-4`, the series `theta/9 - theta^3/900` is used to avoid cancellation.
+  ///
+  /// @param[in] theta Parameter of the Frank copula.
+  ///
+  /// @return Value of Kendall's tau.
+  template <class Type>
+  Type tfrank(Type theta) {
+    Type a = fabs(theta);
+    if(a < Type(1e-4)) return theta / Type(9.0) * (Type(1.0) - theta * theta / Type(100.0));
+    Type D = Type(0.0);
+    if(a <= Type(5.0)) {
+      Type h = Type(.5) * a;
+      for(int ii=0; ii<gauss_legendre::n_half; ii++) {
+        Type t1 = h * (Type(1.0) + gauss_legendre::x[ii]);
+        Type t2 = h * (Type(1.0) - gauss_legendre::x[ii]);
+        D += gauss_legendre::w[ii] * (t1 / expm1(t1) + t2 / expm1(t2));
+      }
+      D *= h;
+    } else {
+      D = Type(M_PI * M_PI / 6.0);
+      for(int k=1; k<=int(40.0/asDouble(a))+1; k++) {
+        D -= exp(-k * a) * (a/Type(k) + Type(1.0)/Type(k*k));
+      }
+    }
+    Type ans = Type(1.0) - Type(4.0) / a * (Type(1.0) - D / a);
+    return (theta < Type(0.0)) ? -ans : ans;
+  }
+
 } // end namespace LocalCop
 
 #endif // LOCALCOP_FRANK_HPP
@@ -5,6 +5,7 @@
 
 // this is where RefVector_t etc. is defined
 #include "config.hpp"
+#include "quadrature.hpp"
 
 #ifndef M_LN_SQRT_2PI
 #define M_LN_SQRT_2PI  0.918938533204672741780329736406
@@ -14,56 +15,6 @@
 
 namespace LocalCop {
 
-  // TODO: This code is a TMB example, copied here to test how it works. Need to replace it with pgaussian.
-  /*
-    This class evaluates the integral of the exponential density with rate parameter lambda from lower to upper
-  */
-  template<class Float>
-  struct Exponential {
-    typedef Float Scalar; // Required by integrate
-    Float x, theta;         // Parameters 
-    // Evaluate exponential density
-    Float operator() (Float z) {
-      Float ans = dexp(z, theta, 0);
-      // Float ans = theta * exp(- theta * z); 
-      return ans;
-    }
-    // Integrate latent variable z out
-    Float integrate() {
-      using gauss_kronrod::integrate;
-      Float ans =
-        integrate(*this, 0, x);
-      return ans;
-    }
-  };
-
-
-  // An externally available integration evaluator
-  template<class Float>
-  Float exponential_evaluator(Float x, Float theta) {
-    Exponential<Float> f = {x, theta};
-    return f.integrate();
-  }
-
-  VECTORIZE2_tt(exponential_evaluator)
-
-  // The code below performs the same thing as VECTORIZE2_tt above, but for tiny_ad instead of CppAD
-  // // 2. Run the evaluator through tiny_ad and obtain an atomic function
-  // //    'exponential_integral'.  The '11' tells tiny_ad that we need a derivative
-  // //    with respect to every variable so that we can test the gradient.
-  // TMB_BIND_ATOMIC(exponential_integral, 11, exponential_evaluator(x[0], x[1]))
-  // // 3. Create a more user-friendly version ('exponential_integral' takes vector
-  // //    arguments and there's a final invisible argument that
-  // //    corresponds to the derivative order)
-  // template<class Type>
-  // Type IntegralFunctionTest(Type x, Type theta) {
-  //   vector<Type> args(3); // Last index reserved for derivative order
-  //   args << x, theta, 0;
-  //   return LocalCop::exponential_integral(CppAD::vector<Type>(args))[0];
-  // }
-
-
-
   /// Calculate Gaussian copula partial derivative with respect to u1.
   ///
   /// @param[in] u1 First uniform variable.
@@ -81,7 +32,36 @@ namespace LocalCop {
     if(give_log) return log(ans); else return ans;
   }
   VECTORIZE4_ttti(hgaussian)
+
+  /// Calculate the inverse of the Gaussian copula h-function with respect to u2.
+  ///
+  /// @param[in] p Probability.
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] theta Parameter of the Gaussian copula with the range $(-1, 1)$.
+  ///
+  /// @return Value of `u2` such that `hgaussian(u1, u2, theta) = p`.
+  template <class Type>
+  Type hinvgaussian(Type p, Type u1, Type theta) {
+    Type z = qnorm(p) * sqrt(Type(1.0) - theta * theta) + theta * qnorm(u1);
+    return pnorm(z);
+  }
       
+  /// Calculate Gaussian copula PDF in terms of normal quantiles.
+  ///
+  /// @param[in] z1 First normal quantile, i.e., `qnorm(u1)`.
+  /// @param[in] z2 Second normal quantile, i.e., `qnorm(u2)`.
+  /// @param[in] theta Parameter of the Gaussian copula with the range $(-1, 1)$.
+  /// @param give_log Whether or not to return on the log scale.
+  ///
+  /// @return Value of the copula PDF.
+  template <class Type>
+  Type dgaussian_z(Type z1, Type z2, Type theta, int give_log=0) {
+    Type det = 1.0 - theta*theta;
+    Type ans = theta*theta * (z1*z1 + z2*z2) - 2.0*theta * z1*z2;
+    ans = -.5 * (ans / det + log(det));
+    if(give_log) return ans; else return exp(ans);
+  }
+
   /// Calculate Gaussian copula PDF.
   ///
   /// @param[in] u1 First uniform variable.
@@ -93,14 +73,129 @@ namespace LocalCop {
   template <class Type>
   Type dgaussian(Type u1, Type u2, Type theta, int give_log=0) {
     // normal quantiles
+    return dgaussian_z(Type(qnorm(u1)), Type(qnorm(u2)), theta, give_log);
+  }
+  VECTORIZE4_ttti(dgaussian)
+
+  /// Calculate Gaussian copula log-PDF and its derivatives on the calibration scale.
+  ///
+  /// The copula parameter is `theta = tanh(eta)`.  With `a = z1^2 + z2^2` and `b = z1 * z2`, the first two derivatives of the log-PDF with respect to `eta` are
+  ///
+  /// ```
+  /// d1 = theta - (theta * a - (1 + theta^2) * b) / (1 - theta^2),
+  /// d2 = (1 - theta^2) - ((1 + theta^2) * a - 4 * theta * b) / (1 - theta^2).
+  /// ```
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] eta Dependence parameter on the calibration scale.
+  /// @param[out] d1 First derivative of the log-PDF with respect to `eta`.
+  /// @param[out] d2 Second derivative of the log-PDF with respect to `eta`.
+  ///
+  /// @return Value of the copula log-PDF.
+  template <class Type>
+  Type dgaussian_eta(Type u1, Type u2, Type eta, Type& d1, Type& d2) {
     Type z1 = qnorm(u1);
     Type z2 = qnorm(u2);
-    Type det = 1.0 - theta*theta;
-    Type ans = theta*theta * (z1*z1 + z2*z2) - 2.0*theta * z1*z2;
-    ans = -.5 * (ans / det + log(det));
-    if(give_log) return ans; else return exp(ans);
+    Type theta = exp(Type(2.0) * eta);
+    theta = (theta - Type(1.0)) / (theta + Type(1.0));
+    Type theta2 = theta * theta;
+    Type det = Type(1.0) - theta2;
+    Type a = z1*z1 + z2*z2;
+    Type b = z1*z2;
+    d1 = theta - (theta * a - (Type(1.0) + theta2) * b) / det;
+    d2 = det - ((Type(1.0) + theta2) * a - Type(4.0) * theta * b) / det;
+    return Type(-.5) * ((theta2 * a - Type(2.0) * theta * b) / det + log(det));
   }
-  VECTORIZE4_ttti(dgaussian)
+
+  /// Bivariate normal CDF.
+  ///
+  /// Calculates `P(X1 < h, X2 < k)` for standard normals with correlation `r`, using the Drezner-Wesolowsky method as refined by Genz (2004), "Numerical computation of rectangular bivariate and trivariate normal and t probabilities", *Statistics and Computing*, 14:251-260.  For `|r| < 0.925` this is a one-dimensional integral over `asin(r)`, and otherwise an integral over `sqrt(1 - r^2)` after subtracting the singular part.  Both are evaluated with the same 20-point Gauss-Legendre rule for every `r`, such that the computation is a fixed sequence of operations which can be differentiated by AD.  The two branches are combined with conditional expressions, each evaluated at a harmless value of `r` when not selected, so that neither can produce `NaN` derivatives.  Against adaptive quadrature of Plackett's identity in extended precision, the absolute error is usually within a few units of `1e-16`, and below `1e-13` in every case tested.
+  ///
+  /// @param[in] h First upper limit.
+  /// @param[in] k Second upper limit.
+  /// @param[in] r Correlation with the range $(-1, 1)$.
+  ///
+  /// @return Value of the CDF.
+  template <class Type>
+  Type pbvnorm(Type h, Type k, Type r) {
+    using namespace gauss_legendre;
+    const double two_pi = 6.283185307179586;
+    const double r_switch = 0.925;
+    // Genz's algorithm calculates the upper probability at (-h, -k)
+    Type H = -h;
+    Type K = -k;
+    Type hk = H * K;
+    Type abs_r = CppAD::CondExpGe(r, Type(0.0), r, -r);
+    // small |r|: integral over asin(r)
+    Type r1 = CppAD::CondExpLt(abs_r, Type(r_switch), r, Type(0.0));
+    Type hs = (H * H + K * K) / Type(2.0);
+    Type asr = asin(r1);
+    Type bvn1 = Type(0.0);
+    for(int ii=0; ii<n_half; ii++) {
+      Type sn = sin(asr * Type((x[ii] + 1.0) / 2.0));
+      bvn1 += Type(w[ii]) * exp((sn * hk - hs) / (Type(1.0) - sn * sn));
+      sn = sin(asr * Type((1.0 - x[ii]) / 2.0));
+      bvn1 += Type(w[ii]) * exp((sn * hk - hs) / (Type(1.0) - sn * sn));
+    }
+    bvn1 = bvn1 * asr / Type(2.0 * two_pi) + pnorm(-H) * pnorm(-K);
+    // large |r|: integral over sqrt(1 - r^2)
+    Type r2 = CppAD::CondExpLt(abs_r, Type(r_switch), Type(r_switch), r);
+    Type sgn = CppAD::CondExpLt(r2, Type(0.0), Type(-1.0), Type(1.0));
+    Type K2 = sgn * K;
+    Type hk2 = sgn * hk;
+    Type as = (Type(1.0) - r2) * (Type(1.0) + r2);
+    Type a = sqrt(as);
+    Type hmk = H - K2;
+    Type bs = hmk * hmk;
+    Type b = CppAD::CondExpGe(hmk, Type(0.0), hmk, -hmk);
+    Type c = (Type(4.0) - hk2) / Type(8.0);
+    Type d = (Type(12.0) - hk2) / Type(16.0);
+    Type bvn2 = a * exp(-(bs / as + hk2) / Type(2.0)) *
+      (Type(1.0) - c * (bs - as) * (Type(1.0) - d * bs / Type(5.0)) / Type(3.0) +
+       c * d * as * as / Type(5.0));
+    Type hk2_safe = CppAD::CondExpLt(hk2, Type(-160.0), Type(0.0), hk2);
+    Type bvn_sing = exp(-hk2_safe / Type(2.0)) * Type(sqrt(two_pi)) *
+      pnorm(-b / a) * b *
+      (Type(1.0) - c * bs * (Type(1.0) - d * bs / Type(5.0)) / Type(3.0));
+    bvn2 -= CppAD::CondExpLt(hk2, Type(-160.0), Type(0.0), bvn_sing);
+    a = a / Type(2.0);
+    for(int ii=0; ii<n_half; ii++) {
+      Type xs = a * Type(x[ii] + 1.0);
+      xs = xs * xs;
+      Type rs = sqrt(Type(1.0) - xs);
+      bvn2 += a * Type(w[ii]) *
+        (exp(-bs / (Type(2.0) * xs) - hk2 / (Type(1.0) + rs)) / rs -
+         exp(-(bs / xs + hk2) / Type(2.0)) *
+         (Type(1.0) + c * xs * (Type(1.0) + d * xs)));
+      xs = as * Type((1.0 - x[ii]) * (1.0 - x[ii]) / 4.0);
+      rs = sqrt(Type(1.0) - xs);
+      bvn2 += a * Type(w[ii]) * exp(-(bs / xs + hk2) / Type(2.0)) *
+        (exp(-hk2 * xs / (Type(2.0) * (Type(1.0) + rs) * (Type(1.0) + rs))) / rs -
+         (Type(1.0) + c * xs * (Type(1.0) + d * xs)));
+    }
+    bvn2 = -bvn2 / Type(two_pi);
+    Type max_hk = CppAD::CondExpGe(H, K2, H, K2);
+    Type pdiff = pnorm(-H) - pnorm(-K2);
+    pdiff = CppAD::CondExpLt(pdiff, Type(0.0), Type(0.0), pdiff);
+    bvn2 = CppAD::CondExpLt(r2, Type(0.0), pdiff - bvn2, bvn2 + pnorm(-max_hk));
+    return CppAD::CondExpLt(abs_r, Type(r_switch), bvn1, bvn2);
+  }
+
+  /// Calculate Gaussian copula CDF.
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] theta Parameter of the Gaussian copula with the range $(-1, 1)$.
+  /// @param give_log Whether or not to return on the log scale.
+  ///
+  /// @return Value of the copula CDF.  See `pbvnorm()`.
+  template <class Type>
+  Type pgaussian(Type u1, Type u2, Type theta, int give_log=0) {
+    Type ans = pbvnorm(Type(qnorm(u1)), Type(qnorm(u2)), theta);
+    if(give_log) return log(ans); else return ans;
+  }
+  VECTORIZE4_ttti(pgaussian)
 
 } // end namespace LocalCop
 
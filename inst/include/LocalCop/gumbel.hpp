@@ -42,21 +42,53 @@ namespace LocalCop {
     if(give_log) return logans; else return exp(logans);
   }
   VECTORIZE4_ttti(hgumbel)
+
+  /// Calculate the inverse of the Gumbel copula h-function with respect to u2.
+  ///
+  /// With `x = -log(u1)`, `y = -log(u2)`, and `z = (x^theta + y^theta)^(1/theta)`, the equation `hgumbel(u1, u2, theta) = p` becomes
+  ///
+  /// ```
+  /// g(z) = z + (theta - 1) log(z) - x - (theta - 1) log(x) + log(p) = 0,
+  /// ```
+  ///
+  /// for `z >= x`.  Since `g` is increasing and concave with `g(x) = log(p) <= 0`, Newton's method started at `z = x` increases monotonically to the root without overshooting it.  The iterations are safeguarded by never letting `z` decrease, and by stopping after `maxit` steps.  Then `y = x * ((z/x)^theta - 1)^(1/theta)`.
+  ///
+  /// @param[in] p Probability.
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] theta Parameter of the Gumbel copula with the range $[1,\infty]$.
+  /// @param[in] maxit Maximum number of Newton steps.
+  ///
+  /// @return Value of `u2` such that `hgumbel(u1, u2, theta) = p`.
+  template <class Type>
+  Type hinvgumbel(Type p, Type u1, Type theta, int maxit = 50) {
+    Type x = -log(u1);
+    Type tm1 = theta - Type(1.0);
+    Type rhs = x + tm1 * log(x) - log(p);
+    Type z = x;
+    for(int ii=0; ii<maxit; ii++) {
+      Type step = (rhs - z - tm1 * log(z)) / (Type(1.0) + tm1 / z);
+      if(!(step > Type(0.0))) break;
+      z += step;
+      if(step <= Type(1e-15) * z) break;
+    }
+    Type y = x * exp(log(expm1(theta * log1p((z - x)/x))) / theta);
+    return exp(-y);
+  }
       
-  /// Calculate Gumbel copula PDF.
+  /// Calculate Gumbel copula PDF in terms of the log-uniforms.
   //
-  /// @param[in] u1 First uniform variable.
-  /// @param[in] u2 Second uniform variable.
+  /// @param[in] log_u1 Logarithm of the first uniform variable.
+  /// @param[in] log_u2 Logarithm of the second uniform variable.
+  /// @param[in] loglog_u1 Value of `log(-log(u1))`.
+  /// @param[in] loglog_u2 Value of `log(-log(u2))`.
   /// @param[in] theta Parameter of the Gumbel copula with the range $[1,\infty]$.
   /// @param give_log Whether or not to return on the log scale.
   ///
   /// @return Value of the copula PDF.
   template <class Type>
-  Type dgumbel(Type u1, Type u2, Type theta, int give_log=0) {
-    Type log_u1 = log(u1);
-    Type log_u2 = log(u2);
-    Type loglog_u1 = log(-log_u1);
-    Type loglog_u2 = log(-log_u2);
+  Type dgumbel_log(Type log_u1, Type log_u2,
+                   Type loglog_u1, Type loglog_u2,
+                   Type theta, int give_log=0) {
     Type log_theta = log(theta - 1.0);
     Type lsum = logspace_add(theta * loglog_u1, theta * loglog_u2);
     Type ans = (theta - 1.0) * (loglog_u1 + loglog_u2);
@@ -65,8 +97,74 @@ namespace LocalCop {
     ans -= log_u1 + log_u2;
     if(give_log) return ans; else return exp(ans);
   }
+
+  /// Calculate Gumbel copula PDF.
+  //
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] theta Parameter of the Gumbel copula with the range $[1,\infty]$.
+  /// @param give_log Whether or not to return on the log scale.
+  ///
+  /// @return Value of the copula PDF.
+  template <class Type>
+  Type dgumbel(Type u1, Type u2, Type theta, int give_log=0) {
+    Type log_u1 = log(u1);
+    Type log_u2 = log(u2);
+    return dgumbel_log(log_u1, log_u2, Type(log(-log_u1)), Type(log(-log_u2)),
+                       theta, give_log);
+  }
   VECTORIZE4_ttti(dgumbel)
 
+  /// Calculate Gumbel copula log-PDF and its derivatives on the calibration scale.
+  ///
+  /// The copula parameter is `theta = 1 + exp(eta)`.  With `t_i = -log(u_i)`, `L = log(t1^theta + t2^theta)`, and `A = exp(L/theta)`, the log-PDF is
+  ///
+  /// ```
+  /// (theta-1) (log(t1) + log(t2)) + (1/theta - 2) L - A + log(A + theta - 1) + t1 + t2,
+  /// ```
+  ///
+  /// and the derivatives with respect to `theta` are obtained from those of `L`, which are the mean and variance of `log(t_i)` with weights proportional to `t_i^theta`.
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] eta Dependence parameter on the calibration scale.
+  /// @param[out] d1 First derivative of the log-PDF with respect to `eta`.
+  /// @param[out] d2 Second derivative of the log-PDF with respect to `eta`.
+  ///
+  /// @return Value of the copula log-PDF.
+  template <class Type>
+  Type dgumbel_eta(Type u1, Type u2, Type eta, Type& d1, Type& d2) {
+    Type s = exp(eta);
+    Type theta = Type(1.0) + s;
+    Type t1 = -log(u1);
+    Type t2 = -log(u2);
+    Type lt1 = log(t1);
+    Type lt2 = log(t2);
+    Type L = logspace_add(theta * lt1, theta * lt2);
+    // derivatives of L with respect to theta
+    Type w1 = exp(theta * lt1 - L);
+    Type w2 = exp(theta * lt2 - L);
+    Type L1 = w1 * lt1 + w2 * lt2;
+    Type L2 = w1 * lt1 * lt1 + w2 * lt2 * lt2 - L1 * L1;
+    // derivatives of A = exp(m) with m = L/theta
+    Type itheta = Type(1.0) / theta;
+    Type m = L * itheta;
+    Type m1 = (L1 - m) * itheta;
+    Type m2 = (L2 - Type(2.0) * m1) * itheta;
+    Type A = exp(m);
+    Type A1 = A * m1;
+    Type A2 = A * (m2 + m1 * m1);
+    Type B = A + s; // A + theta - 1
+    Type B1 = (A1 + Type(1.0)) / B;
+    Type l1 = lt1 + lt2 - m * itheta + (itheta - Type(2.0)) * L1 - A1 + B1;
+    Type l2 = Type(2.0) * (m - L1) * itheta * itheta;
+    l2 += (itheta - Type(2.0)) * L2 - A2 + A2 / B - B1 * B1;
+    // chain rule with dtheta/deta = theta - 1
+    d1 = s * l1;
+    d2 = d1 + s * s * l2;
+    return s * (lt1 + lt2) + (itheta - Type(2.0)) * L - A + log(B) + t1 + t2;
+  }
+
 } // end namespace LocalCop
 
 #endif // LOCALCOP_GUMBEL_HPP
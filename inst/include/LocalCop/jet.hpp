@@ -0,0 +1,162 @@
+/// @file jet.hpp
+///
+/// @brief Second-order forward-mode differentiation of scalar functions.
+///
+/// A `Jet` carries the value of a scalar function along with its first and second derivatives with respect to a single input.  Instantiating the copula family templates with `Type = Jet` thus gives the exact score and curvature of the log-density with respect to the calibration parameter, without building an AD tape.
+
+#ifndef LOCALCOP_JET_HPP
+#define LOCALCOP_JET_HPP
+
+// this is where RefVector_t etc. is defined
+#include "config.hpp"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace LocalCop {
+
+  // separate namespace so that the scalar overloads below don't hide the
+  // double-precision versions of log(), exp(), etc., for unqualified calls
+  // inside namespace LocalCop.  Overloads are found by ADL.
+  namespace jet {
+
+    /// Scalar with first and second derivative with respect to one input.
+    class Jet {
+    public:
+      double val; ///< Function value.
+      double d1; ///< First derivative.
+      double d2; ///< Second derivative.
+      /// Constant (or variable if `d1 = 1`).
+      Jet(double v = 0.0, double dv1 = 0.0, double dv2 = 0.0) :
+        val(v), d1(dv1), d2(dv2) {}
+      /// Whether the derivatives are identically zero.
+      bool is_constant() const { return (d1 == 0.0) && (d2 == 0.0); }
+      Jet& operator+=(const Jet& y) {
+        val += y.val; d1 += y.d1; d2 += y.d2;
+        return *this;
+      }
+      Jet& operator-=(const Jet& y) {
+        val -= y.val; d1 -= y.d1; d2 -= y.d2;
+        return *this;
+      }
+      Jet& operator*=(const Jet& y) {
+        d2 = d2 * y.val + 2.0 * d1 * y.d1 + val * y.d2;
+        d1 = d1 * y.val + val * y.d1;
+        val *= y.val;
+        return *this;
+      }
+      Jet& operator/=(const Jet& y);
+    };
+
+    /// Apply a scalar function `f` with derivatives `df` and `d2f` evaluated at `x.val`.
+    inline Jet chain(const Jet& x, double f, double df, double d2f) {
+      return Jet(f, df * x.d1, d2f * x.d1 * x.d1 + df * x.d2);
+    }
+
+    inline Jet operator-(const Jet& x) {
+      return Jet(-x.val, -x.d1, -x.d2);
+    }
+    inline Jet operator+(Jet x, const Jet& y) { return x += y; }
+    inline Jet operator-(Jet x, const Jet& y) { return x -= y; }
+    inline Jet operator*(Jet x, const Jet& y) { return x *= y; }
+    inline Jet inverse(const Jet& x) {
+      double ix = 1.0/x.val;
+      return chain(x, ix, -ix*ix, 2.0*ix*ix*ix);
+    }
+    inline Jet& Jet::operator/=(const Jet& y) {
+      return *this *= inverse(y);
+    }
+    inline Jet operator/(Jet x, const Jet& y) { return x /= y; }
+
+    // comparisons are on the value only
+    inline bool operator<(const Jet& x, const Jet& y) { return x.val < y.val; }
+    inline bool operator>(const Jet& x, const Jet& y) { return x.val > y.val; }
+    inline bool operator<=(const Jet& x, const Jet& y) { return x.val <= y.val; }
+    inline bool operator>=(const Jet& x, const Jet& y) { return x.val >= y.val; }
+
+    inline Jet exp(const Jet& x) {
+      double ex = std::exp(x.val);
+      return chain(x, ex, ex, ex);
+    }
+    inline Jet log(const Jet& x) {
+      double ix = 1.0/x.val;
+      return chain(x, std::log(x.val), ix, -ix*ix);
+    }
+    inline Jet log1p(const Jet& x) {
+      double ix = 1.0/(1.0 + x.val);
+      return chain(x, std::log1p(x.val), ix, -ix*ix);
+    }
+    inline Jet sqrt(const Jet& x) {
+      double sx = std::sqrt(x.val);
+      return chain(x, sx, .5/sx, -.25/(sx*x.val));
+    }
+    inline Jet pow(const Jet& x, const Jet& y) {
+      if(y.is_constant()) {
+        double xy1 = std::pow(x.val, y.val - 1.0);
+        return chain(x, xy1 * x.val, y.val * xy1,
+                     y.val * (y.val - 1.0) * xy1 / x.val);
+      }
+      return exp(y * log(x));
+    }
+    inline Jet lgamma(const Jet& x) {
+      return chain(x, std::lgamma(x.val),
+                   R::digamma(x.val), R::trigamma(x.val));
+    }
+    inline Jet logspace_add(const Jet& logx, const Jet& logy) {
+      return (logx > logy) ?
+        logx + log1p(exp(logy - logx)) :
+        logy + log1p(exp(logx - logy));
+    }
+
+    /// Standard normal quantile function.
+    inline Jet qnorm(const Jet& p) {
+      double z = R::qnorm(p.val, 0.0, 1.0, 1, 0);
+      double iphi = 1.0/R::dnorm(z, 0.0, 1.0, 0);
+      return chain(p, z, iphi, z * iphi * iphi);
+    }
+
+    /// Standard normal CDF.
+    inline Jet pnorm(const Jet& q) {
+      double phi = R::dnorm(q.val, 0.0, 1.0, 0);
+      return chain(q, R::pnorm(q.val, 0.0, 1.0, 1, 0), phi, -q.val * phi);
+    }
+
+    /// Student-t density.
+    inline Jet dt(const Jet& x, const Jet& df, int give_log) {
+      Jet ans = lgamma(.5 * (df + 1.0)) - lgamma(.5 * df);
+      ans -= .5 * log(M_PI * df) + .5 * (df + 1.0) * log1p(x*x/df);
+      if(give_log) return ans; else return exp(ans);
+    }
+
+    /// Student-t CDF.
+    ///
+    /// @warning Derivatives are only calculated with respect to `q`, i.e., `df` must be a constant.
+    inline Jet pt(const Jet& q, const Jet& df) {
+      if(!df.is_constant()) {
+        throw std::domain_error("pt: derivatives with respect to df are not supported.");
+      }
+      double dens = R::dt(q.val, df.val, 0);
+      return chain(q, R::pt(q.val, df.val, 1, 0), dens,
+                   -dens * (df.val + 1.0) * q.val / (df.val + q.val * q.val));
+    }
+
+    /// Student-t quantile function.
+    ///
+    /// @warning Derivatives are only calculated with respect to `p`, i.e., `df` must be a constant.
+    inline Jet qt(const Jet& p, const Jet& df) {
+      if(!df.is_constant()) {
+        throw std::domain_error("qt: derivatives with respect to df are not supported.");
+      }
+      double q = R::qt(p.val, df.val, 1, 0);
+      double idens = 1.0/R::dt(q, df.val, 0);
+      return chain(p, q, idens,
+                   idens * idens * (df.val + 1.0) * q / (df.val + q * q));
+    }
+
+  } // end namespace jet
+
+  using jet::Jet;
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_JET_HPP
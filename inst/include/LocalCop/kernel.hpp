@@ -0,0 +1,191 @@
+/// @file kernel.hpp
+///
+/// @brief Local likelihood kernel functions and weights.
+
+#ifndef LOCALCOP_KERNEL_HPP
+#define LOCALCOP_KERNEL_HPP
+
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace LocalCop {
+
+  /// Kernel functions.
+  ///
+  /// The integer codes are those returned by `.get_kernel()` in `R/utils.R`, and the functions are identical to those in `R/KernFun.R`.
+  enum class Kernel {
+    Epa = 1, ///< Epanechnikov kernel.
+    Gaus = 2, ///< Gaussian kernel.
+    Beta = 3, ///< Beta kernel with shape parameter `par = 0.5`.
+    BiQuad = 4, ///< Biquadratic kernel.
+    TriAng = 5 ///< Triangular kernel.
+  };
+
+  /// Evaluate the kernel function.
+  ///
+  /// @param[in] t Distance from mode of kernel.
+  /// @param[in] kernel Kernel function.
+  ///
+  /// @return Value of the kernel function at `t`.
+  inline double kernel_fun(double t, Kernel kernel) {
+    const double ibeta = 2.0/M_PI; // 1/beta(.5, 1.5)
+    double t2 = 1.0 - t*t;
+    switch(kernel) {
+    case Kernel::Epa:
+      return t2 > 0.0 ? .75 * t2 : 0.0;
+    case Kernel::Gaus:
+      return std::exp(-.5 * t*t) / std::sqrt(2.0 * M_PI);
+    case Kernel::Beta:
+      return t2 > 0.0 ? std::sqrt(t2) * ibeta : 0.0;
+    case Kernel::BiQuad:
+      return t2 > 0.0 ? 15.0/16.0 * t2*t2 : 0.0;
+    case Kernel::TriAng:
+      t2 = 1.0 - std::abs(t);
+      return t2 > 0.0 ? t2 : 0.0;
+    }
+    return 0.0;
+  }
+
+  /// Whether the kernel has compact support.
+  ///
+  /// @param[in] kernel Kernel function.
+  ///
+  /// @return `true` if the kernel is zero outside of `(-1, 1)`.
+  inline bool kernel_compact(Kernel kernel) {
+    return kernel != Kernel::Gaus;
+  }
+
+  /// Calculate the kernel weight of an observation.
+  ///
+  /// @param[in] x Covariate value of the observation.
+  /// @param[in] x0 Covariate value at which the local likelihood is evaluated.
+  /// @param[in] band Bandwidth parameter.
+  /// @param[in] kernel Kernel function.
+  ///
+  /// @return The weight `kernel((x-x0)/band) / band`.
+  inline double kernel_weight(double x, double x0, double band,
+                              Kernel kernel) {
+    return kernel_fun((x - x0)/band, kernel) / band;
+  }
+
+  /// Bandwidth types.
+  ///
+  /// The integer codes are those of `band_type = c("constant", "variable")` in `KernWeight()`.
+  enum class BandType {
+    Constant = 1, ///< The same bandwidth at every value of `x0`.
+    Variable = 2 ///< Nearest-neighbour bandwidth, i.e., `band` is the fraction of observations with positive weight at each `x0`.
+  };
+
+  /// Index of the nearest neighbour which determines a variable bandwidth.
+  ///
+  /// @param[in] band Fraction of observations, between 0 and 1.
+  /// @param[in] n Number of observations.
+  ///
+  /// @return The (0-based) index `k` such that the bandwidth is the distance from `x0` to its `k+1`th nearest neighbour, as in `KernWeight()`.
+  inline int knn_index(double band, int n) {
+    int k = static_cast<int>(band * n);
+    if(band == 1.0) k--;
+    return std::min(std::max(k, 0), n - 1);
+  }
+
+  /// Distance to the `k+1`th nearest neighbour of `x0` in a sorted vector.
+  ///
+  /// The distances to the left and right of `x0` are two sorted sequences, of which the smallest `k+1` elements of the merged sequence are found by bisecting on the number taken from the left.  The cost is logarithmic in `n`.
+  ///
+  /// @param[in] x Pointer to a sorted vector of covariates.
+  /// @param[in] n Length of `x`.
+  /// @param[in] x0 Covariate value.
+  /// @param[in] k Index of the nearest neighbour, between 0 and `n-1`.
+  ///
+  /// @return The `k+1`th smallest value of `abs(x - x0)`.
+  inline double knn_radius(const double* x, int n, double x0, int k) {
+    int p = std::lower_bound(x, x + n, x0) - x;
+    // distances to the left and right of x0, in increasing order
+    int nl = p;
+    int nr = n - p;
+    auto left = [&](int t) { return x0 - x[p-1-t]; };
+    auto right = [&](int t) { return x[p+t] - x0; };
+    int m = k + 1;
+    int lo = std::max(0, m - nr);
+    int hi = std::min(m, nl);
+    int i = lo;
+    while(lo <= hi) {
+      i = (lo + hi) / 2;
+      int j = m - i;
+      if(i < nl && j > 0 && right(j-1) > left(i)) {
+        lo = i + 1; // too few from the left
+      } else if(i > 0 && j < nr && left(i-1) > right(j)) {
+        hi = i - 1; // too many from the left
+      } else {
+        break;
+      }
+    }
+    int j = m - i;
+    double h = -std::numeric_limits<double>::infinity();
+    if(i > 0) h = left(i-1);
+    if(j > 0) h = std::max(h, right(j-1));
+    return h;
+  }
+
+  /// Distance to the `k+1`th nearest neighbour of `x0` in an unsorted vector.
+  ///
+  /// Uses a partial sort of the distances, the cost of which is linear in `n`.
+  ///
+  /// @param[in] x Pointer to a vector of covariates.
+  /// @param[in] n Length of `x`.
+  /// @param[in] x0 Covariate value.
+  /// @param[in] k Index of the nearest neighbour, between 0 and `n-1`.
+  /// @param[in] work Workspace, resized to `n`.
+  ///
+  /// @return The `k+1`th smallest value of `abs(x - x0)`.
+  inline double knn_radius(const double* x, int n, double x0, int k,
+                           std::vector<double>& work) {
+    work.resize(n);
+    for(int ii=0; ii<n; ii++) work[ii] = std::abs(x[ii] - x0);
+    std::nth_element(work.begin(), work.begin() + k, work.end());
+    return work[k];
+  }
+
+  /// Calculate the kernel weights of all observations.
+  ///
+  /// Same calculation as `KernWeight()` for a scalar `x0` and `band`.  For compact kernels and sorted `x`, only the observations within the bandwidth are evaluated, the rest being set to zero.
+  ///
+  /// @param[in] x Pointer to a vector of covariates.
+  /// @param[in] n Length of `x`.
+  /// @param[in] x0 Covariate value.
+  /// @param[in] band Bandwidth parameter: either the bandwidth itself or the fraction of observations, depending on `band_type`.
+  /// @param[in] kernel Kernel function.
+  /// @param[in] band_type Bandwidth type.
+  /// @param[out] wgt Pointer to a vector of length `n` of kernel weights.
+  inline void kernel_weights(const double* x, int n, double x0, double band,
+                             Kernel kernel, BandType band_type,
+                             double* wgt) {
+    if(n == 0) return;
+    bool sorted = std::is_sorted(x, x + n);
+    double h = band;
+    if(band_type == BandType::Variable) {
+      int k = knn_index(band, n);
+      if(sorted) {
+        h = knn_radius(x, n, x0, k);
+      } else {
+        std::vector<double> work;
+        h = knn_radius(x, n, x0, k, work);
+      }
+    }
+    int lo = 0;
+    int hi = n;
+    if(sorted && kernel_compact(kernel)) {
+      lo = std::upper_bound(x, x + n, x0 - h) - x;
+      hi = std::max(lo, static_cast<int>(std::lower_bound(x + lo, x + n, x0 + h) - x));
+      std::fill(wgt, wgt + lo, 0.0);
+      std::fill(wgt + hi, wgt + n, 0.0);
+    }
+    for(int ii=lo; ii<hi; ii++) wgt[ii] = kernel_weight(x[ii], x0, h, kernel);
+    return;
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_KERNEL_HPP
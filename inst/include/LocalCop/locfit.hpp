@@ -0,0 +1,787 @@
+/// @file locfit.hpp
+///
+/// @brief Local likelihood estimation without AD tapes.
+///
+/// The local likelihood at covariate value `x0` is
+///
+/// ```
+/// ll(beta) = sum_i wgt_i * log_dCopula(u1_i, u2_i, eta_i),    eta_i = X[i,] * beta,
+/// ```
+///
+/// where the rows of the design matrix `X` are the monomials of total degree at most `degree` in the centered covariates `x_i - x0` (see `locpoly_terms()`), such that with a single covariate `eta_i = beta[0] + beta[1] * (x_i - x0) + ... + beta[degree] * (x_i - x0)^degree`.  The kernel weights are `wgt_i = prod_k kernel((x_ik - x0_k)/band_k) / band_k`, a product kernel over the covariates, and with a single covariate `band` is either constant or the distance from `x0` to its nearest neighbour of a given order (see `LocalFit::set_band_type()`).  When the kernel has compact support and the first covariate is sorted, the observations with positive weight lie in a contiguous window `x0 - band < x_i < x0 + band` along it, which is located by binary search, or by sliding the window forward when `x0` increases.  Otherwise, the kernel is evaluated at every observation.  The rows of `X` with positive weight are stored contiguously for each `x0`, such that `eta = X * beta` and the gradient and Hessian below are matrix products over the window, the cost of which is `O(n * p^2)` for `n` observations and `p` coefficients.  Since the log-density depends on `beta` only through the scalar `eta_i`, its gradient and Hessian are obtained exactly as `X' * (wgt * d1)` and `X' * diag(wgt * d2) * X` from the first two derivatives `d1` and `d2` of the log-density with respect to `eta_i`, which are available in closed form for the one-parameter families, and are otherwise calculated by instantiating the family templates with `Type = Jet`.  For the one-parameter families, the observations in the local likelihood are evaluated as a batch with `lpdf_eta_batch()`, which uses SIMD instructions for the exponentials and logarithms when available.  In either case the data are the marginal transformations of `u1` and `u2` calculated by `utrans()`, which are computed once per dataset and shared by every value of `x0`.  The optimum is found with a damped Newton method, the steps of which are obtained by a dense Cholesky factorization of the `p x p` Hessian.
+
+#ifndef LOCALCOP_LOCFIT_HPP
+#define LOCALCOP_LOCFIT_HPP
+
+// this is where RefVector_t etc. is defined
+#include "config.hpp"
+#include "jet.hpp"
+#include "kernel.hpp"
+#include "gaussian.hpp"
+#include "student.hpp"
+#include "clayton.hpp"
+#include "gumbel.hpp"
+#include "frank.hpp"
+#include "transform.hpp"
+#include "batch.hpp"
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace LocalCop {
+
+  /// Copula log-density on the calibration scale.
+  ///
+  /// Same calculation as the `LocalLikelihood` **TMB** model, for a single observation.
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] eta Dependence parameter on the calibration scale.  See `BiCopEta2Par()`.
+  /// @param[in] nu Second copula parameter.  Only used if `family = 2`.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  ///
+  /// @return Value of the copula log-density.
+  template <class Type>
+  Type lpdf_eta(Type u1, Type u2, Type eta, Type nu, int family) {
+    Type v[4];
+    utrans(u1, u2, nu, family, v);
+    return lpdf_eta_utrans(v, eta, nu, family);
+  }
+
+  /// Copula log-density on the calibration scale and its first two derivatives.
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] eta Dependence parameter on the calibration scale.
+  /// @param[in] nu Second copula parameter.  Only used if `family = 2`.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  /// @param[in] analytic Whether to use the closed-form derivatives of the one-parameter families (`dgaussian_eta()`, `dclayton_eta()`, etc.), or forward-mode differentiation with `Jet`.  The Student-t copula always uses the latter.
+  /// @param[out] d1 First derivative of the log-density with respect to `eta`.
+  /// @param[out] d2 Second derivative of the log-density with respect to `eta`.
+  ///
+  /// @return Value of the copula log-density.
+  inline double lpdf_eta_deriv(double u1, double u2, double eta, double nu,
+                               int family, bool analytic,
+                               double& d1, double& d2) {
+    int fam = family % 10;
+    if(analytic && fam != 2) {
+      // rotated copulas
+      if((family == 13) || (family == 14)) {
+        u1 = 1.0 - u1;
+        u2 = 1.0 - u2;
+      } else if((family == 23) || (family == 24)) {
+        u1 = 1.0 - u1;
+      } else if((family == 33) || (family == 34)) {
+        u2 = 1.0 - u2;
+      }
+      if(fam == 1) {
+        return dgaussian_eta(u1, u2, eta, d1, d2);
+      } else if(fam == 3) {
+        return dclayton_eta(u1, u2, eta, d1, d2);
+      } else if(fam == 4) {
+        return dgumbel_eta(u1, u2, eta, d1, d2);
+      } else {
+        return dfrank_eta(u1, u2, eta, d1, d2);
+      }
+    }
+    Jet lpdf = lpdf_eta<Jet>(u1, u2, Jet(eta, 1.0), nu, family);
+    d1 = lpdf.d1;
+    d2 = lpdf.d2;
+    return lpdf.val;
+  }
+
+  /// Marginal transformations of a dataset.
+  ///
+  /// @param[in] u1 Vector of first uniform variables.
+  /// @param[in] u2 Vector of second uniform variables.
+  /// @param[in] nu Second copula parameter.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  /// @param[out] ut Matrix of size `n x utrans_size(family)`, the rows of which are calculated by `utrans()`.
+  inline void utrans(cRefVector_t<double>& u1, cRefVector_t<double>& u2,
+                     double nu, int family, RefMatrix_t<double> ut) {
+    double v[4];
+    int nv = utrans_size(family);
+    for(int ii=0; ii<u1.size(); ii++) {
+      utrans<double>(u1(ii), u2(ii), nu, family, v);
+      for(int jj=0; jj<nv; jj++) ut(ii,jj) = v[jj];
+    }
+    return;
+  }
+
+  /// Number of coefficients of a local polynomial.
+  ///
+  /// @param[in] n_cov Number of covariates.
+  /// @param[in] degree Total degree of the polynomial.
+  ///
+  /// @return The number of monomials of total degree at most `degree` in `n_cov` variables, i.e., `choose(n_cov + degree, degree)`.
+  inline int locpoly_size(int n_cov, int degree) {
+    int ans = 1;
+    for(int kk=1; kk<=degree; kk++) ans = ans * (n_cov + kk) / kk;
+    return ans;
+  }
+
+  /// Monomials of a local polynomial.
+  ///
+  /// The monomials are ordered by total degree, starting with the intercept followed by the `n_cov` covariates themselves.  Each monomial after the first is the product of an earlier monomial and a single covariate, such that the columns of the design matrix can be calculated recursively with one multiplication per element.  The monomials of degree `g` are obtained from those of degree `g-1` in order, each multiplied by the covariates whose index is at least that of its own last factor, which lists each monomial exactly once.  With two covariates and `degree = 2`, the monomials are `1, x1, x2, x1^2, x1*x2, x2^2`.  This is the same order as the columns of the design matrix calculated in R by `CondiCopLocFun()`.
+  ///
+  /// @param[in] n_cov Number of covariates.
+  /// @param[in] degree Total degree of the polynomial.
+  /// @param[out] parent Vector of length `locpoly_size(n_cov, degree)` of indices of the earlier monomial, with `-1` for the intercept.
+  /// @param[out] var Vector of the same length of (0-based) indices of the covariate by which the earlier monomial is multiplied.
+  inline void locpoly_terms(int n_cov, int degree,
+                            std::vector<int>& parent, std::vector<int>& var) {
+    parent.assign(1, -1);
+    var.assign(1, 0);
+    int start = 0;
+    for(int gg=1; gg<=degree; gg++) {
+      int end = parent.size();
+      for(int tt=start; tt<end; tt++) {
+        for(int kk=var[tt]; kk<n_cov; kk++) {
+          parent.push_back(tt);
+          var.push_back(kk);
+        }
+      }
+      start = end;
+    }
+    return;
+  }
+
+  /// Local likelihood estimation with a fixed dataset, kernel and bandwidth.
+  ///
+  /// The data are not copied, so must outlive the object.  In particular, several objects can share the same matrix of marginal transformations.
+  class LocalFit {
+  private:
+    static const int PMAX = 20; // maximum number of parameters
+    static const int DMAX = 3; // maximum number of covariates
+    typedef Matrix<double, Dynamic, 1, 0, PMAX, 1> Coef_t;
+    typedef Matrix<double, Dynamic, Dynamic, 0, PMAX, PMAX> Hess_t;
+    // data
+    cRefMatrix_t<double> utrans_; // marginal transformations of u1 and u2
+    cRefMatrix_t<double> xmat_; // covariates
+    cRefVector_t<double> x_; // first covariate
+    int n_obs_;
+    int n_cov_;
+    const double* freq_; // frequency weights, or nullptr
+    int family_;
+    double nu_;
+    int n_par_;
+    std::vector<int> parent_, var_; // monomials of the local polynomial
+    Kernel kernel_;
+    BandType band_type_;
+    double band_par_; // bandwidth parameter
+    double band_; // bandwidth of the first covariate at the current value of x0
+    double band_ratio_[DMAX]; // bandwidth of each covariate relative to the first
+    bool sorted_; // whether the first covariate is sorted
+    // control parameters
+    int maxit_;
+    double reltol_;
+    bool analytic_; // closed-form or forward-mode derivatives
+    // workspace for a given x0
+    bool window_; // whether observations with positive weight are in a window
+    bool contig_; // whether every observation in the window is stored
+    int lo_; // start of window
+    int hi_; // end of window (exclusive)
+    double lower_; // lower limit of window
+    double upper_; // upper limit of window
+    std::vector<double> dist_; // workspace for variable bandwidths
+    double x0_[DMAX]; // current value of x0
+    bool has_x0_; // whether x0 has been set
+    std::vector<int> iwgt_; // indices of observations with positive weight
+    std::vector<double> wgt_; // positive weights
+    std::vector<double> xd_; // design matrix, column-major
+    std::vector<double> wx_; // workspace for the hessian
+    // batched evaluation
+    int n_trans_; // number of marginal transformations
+    std::vector<double> eta_buf_, ld_buf_, d1_buf_, d2_buf_;
+    std::vector<double> ut_buf_;
+    /// Whether to use batched evaluation.
+    bool use_batch() const { return analytic_ && has_lpdf_batch(family_); }
+    /// Design matrix at the current value of `x0`.
+    Map<const MatrixXd> design() const {
+      return Map<const MatrixXd>(xd_.data(), wgt_.size(), n_par_);
+    }
+    /// Batched evaluation of the log-density at each observation with positive weight.
+    void eval_batch(bool deriv);
+    /// Evaluation of the log-density one observation at a time for a given family.
+    template <template<class> class Family>
+    void eval_family(bool deriv);
+    /// Function object for dispatching `eval_family()` on the copula family.
+    struct EvalFamily {
+      typedef void result_type;
+      LocalFit* self;
+      bool deriv;
+      template <template<class> class Family>
+      void operator()(FamilyTag<Family>) const {
+        self->eval_family<Family>(deriv);
+      }
+    };
+    /// Evaluation of the log-density at each observation with positive weight, with either `eval_batch()` or `eval_family()`.
+    void eval_lpdf(const Coef_t& beta, bool deriv);
+    /// Index of the `jj`th observation with positive weight.
+    int obs(int jj) const { return contig_ ? lo_ + jj : iwgt_[jj]; }
+    /// Locate the window of observations with positive weight.
+    void set_window(double x0);
+    /// Kernel weights and design matrix at a covariate value.
+    void set_point(const double* x0, int drop);
+    // results
+    double nll_;
+    Coef_t grad_;
+    Hess_t hess_;
+    int niter_;
+    /// Negative local log-likelihood.
+    double eval_nll(const Coef_t& beta);
+    /// Negative local log-likelihood, gradient, and hessian.
+    double eval_deriv(const Coef_t& beta);
+    /// Position of an observation among those with positive weight, or -1.
+    int active_index(int ii) const;
+    /// Modified Newton step from the current gradient and Hessian.
+    double newton_step(Coef_t& step) const;
+    /// Whether no observation has positive weight.
+    bool no_weight() const;
+    /// Result of a fit without observations.
+    int fit_empty(RefVector_t<double> beta);
+  public:
+    /// Constructor.
+    LocalFit(cRefMatrix_t<double>& utrans,
+             cRefMatrix_t<double>& x,
+             int family, double nu, int degree,
+             Kernel kernel, double band);
+    /// Set the optimization control parameters.
+    void set_control(int maxit, double reltol);
+    /// Set the method of calculating derivatives: closed-form with `lpdf_eta_batch()` where available, or forward-mode with `Jet`.
+    void set_analytic(bool analytic) { analytic_ = analytic; }
+    /// Set the bandwidth type.
+    void set_band_type(BandType band_type);
+    /// Set a different bandwidth for each covariate.
+    void set_band(cRefVector_t<double>& band);
+    /// Bandwidth of the first covariate at the current value of `x0`.
+    double band() const { return band_; }
+    /// Set frequency weights of the observations.
+    void set_freq(const double* freq);
+    /// Set the covariate value at which to evaluate the local likelihood.
+    void set_x0(double x0, int drop = -1);
+    /// Set the covariate values at which to evaluate the local likelihood.
+    void set_x0(cRefVector_t<double>& x0, int drop = -1);
+    /// Set the weight of an observation to zero at the current value of `x0`.
+    void drop_obs(int ii);
+    /// Fit the local likelihood at the current value of `x0`.
+    int fit(RefVector_t<double> beta);
+    /// Approximate leave-one-out estimate from the last fit.
+    int downdate(int ii, RefVector_t<double> beta, int nsteps);
+    /// Number of covariates.
+    int n_cov() const { return n_cov_; }
+    /// Number of local polynomial coefficients.
+    int n_par() const { return n_par_; }
+    /// Number of active observations, i.e., with positive weight.
+    int n_active() const { return wgt_.size(); }
+    /// Number of Newton iterations used by the last call to `fit()`.
+    int niter() const { return niter_; }
+    /// Value of the negative local log-likelihood at the last fit.
+    double nll() const { return nll_; }
+    /// Value of the negative local log-likelihood at given coefficients.
+    double nll(cRefVector_t<double>& beta);
+    /// Hessian of the negative local log-likelihood at the last fit.
+    void hessian(RefMatrix_t<double> H) const { H = hess_; }
+    /// Standard errors of the last fit, i.e., `sqrt(diag(hessian^{-1}))`.
+    void std_err(RefVector_t<double> se) const;
+  };
+
+  /// @param[in] utrans Matrix of marginal transformations of the uniform responses, with one row per observation and `utrans_size(family)` columns.  See `utrans()`.
+  /// @param[in] x Matrix of covariates, with one row per observation and between one and three columns.  A vector is taken as a single covariate.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  /// @param[in] nu Second copula parameter.
+  /// @param[in] degree Total degree of the local polynomial, such that the number of coefficients `locpoly_size(ncol(x), degree)` is at most 20.
+  /// @param[in] kernel Kernel function.
+  /// @param[in] band Kernel bandwidth of every covariate.  See `set_band()`.
+  inline LocalFit::LocalFit(cRefMatrix_t<double>& utrans,
+                            cRefMatrix_t<double>& x,
+                            int family, double nu, int degree,
+                            Kernel kernel, double band) :
+    utrans_(utrans), xmat_(x), x_(xmat_.col(0)), family_(family), nu_(nu),
+    kernel_(kernel), band_type_(BandType::Constant),
+    band_par_(band), band_(band) {
+    n_obs_ = xmat_.rows();
+    n_cov_ = xmat_.cols();
+    if(n_cov_ < 1 || n_cov_ > DMAX || degree < 0 ||
+       locpoly_size(n_cov_, degree) > PMAX) {
+      throw std::invalid_argument("LocalFit requires 1-3 covariates and at most 20 local polynomial coefficients.");
+    }
+    freq_ = nullptr;
+    n_par_ = locpoly_size(n_cov_, degree);
+    locpoly_terms(n_cov_, degree, parent_, var_);
+    for(int kk=0; kk<DMAX; kk++) {
+      band_ratio_[kk] = 1.0;
+      x0_[kk] = 0.0;
+    }
+    sorted_ = std::is_sorted(x_.data(), x_.data() + n_obs_);
+    window_ = kernel_compact(kernel_) && sorted_;
+    contig_ = window_ && n_cov_ == 1;
+    lo_ = 0;
+    hi_ = 0;
+    lower_ = 0.0;
+    upper_ = 0.0;
+    has_x0_ = false;
+    grad_ = Coef_t::Zero(n_par_);
+    hess_ = Hess_t::Zero(n_par_, n_par_);
+    if(!contig_) iwgt_.reserve(n_obs_);
+    wgt_.reserve(n_obs_);
+    set_control(100, 1e-10);
+    analytic_ = true;
+    n_trans_ = utrans_size(family_);
+    nll_ = 0.0;
+    niter_ = 0;
+  }
+
+  /// @param[in] maxit Maximum number of Newton iterations.
+  /// @param[in] reltol Relative tolerance.  The algorithm stops when half the Newton decrement is less than `reltol * (abs(nll) + reltol)`.
+  inline void LocalFit::set_control(int maxit, double reltol) {
+    maxit_ = maxit;
+    reltol_ = reltol;
+    return;
+  }
+
+  /// With `BandType::Variable`, the bandwidth parameter passed to the constructor is the fraction of observations, and the bandwidth at each `x0` is the distance to the nearest neighbour given by `knn_index()`.  This is found in logarithmic time when `x` is sorted, and otherwise in linear time.  The neighbours are counted as rows of the data, i.e., without frequency weights.  Variable bandwidths require a single covariate.  Takes effect at the next call to `set_x0()`.
+  ///
+  /// @param[in] band_type Bandwidth type.
+  inline void LocalFit::set_band_type(BandType band_type) {
+    if(band_type == BandType::Variable && n_cov_ > 1) {
+      throw std::invalid_argument("Variable bandwidths require a single covariate.");
+    }
+    band_type_ = band_type;
+    if(band_type_ == BandType::Constant) band_ = band_par_;
+    return;
+  }
+
+  /// The kernel weight of each observation is the product over covariates of `kernel((x_ik - x0_k)/band_k) / band_k`.  With `BandType::Variable`, the bandwidth parameter is the fraction of observations as in `set_band_type()`.  Takes effect at the next call to `set_x0()`.
+  ///
+  /// @param[in] band Vector of positive bandwidths, either of length one, in which case it is used for every covariate, or with one element per covariate.
+  inline void LocalFit::set_band(cRefVector_t<double>& band) {
+    if(band.size() != 1 && band.size() != n_cov_) {
+      throw std::invalid_argument("band must have length 1 or one element per covariate.");
+    }
+    band_par_ = band(0);
+    for(int kk=0; kk<n_cov_; kk++) {
+      band_ratio_[kk] = band(band.size() == 1 ? 0 : kk) / band_par_;
+    }
+    if(band_type_ == BandType::Constant) band_ = band_par_;
+    return;
+  }
+
+  /// The local likelihood becomes `sum_i freq_i * wgt_i * log c(u1_i, u2_i | eta_i)`, such that each row of `utrans` and element of `x` counts as `freq_i` observations.  This is used for binned data, where each row is a bin of `freq_i` observations.  Takes effect at the next call to `set_x0()`.
+  ///
+  /// @param[in] freq Pointer to a vector of `n` nonnegative frequency weights, which must outlive the object, or `nullptr` for unit weights.
+  inline void LocalFit::set_freq(const double* freq) {
+    freq_ = freq;
+    return;
+  }
+
+  /// @param[in] beta Local polynomial coefficients, of which the first `n_par()` are used.
+  ///
+  /// @return The negative local log-likelihood at the current value of `x0`.
+  inline double LocalFit::nll(cRefVector_t<double>& beta) {
+    return eval_nll(beta.head(n_par_));
+  }
+
+  /// Slides the window `[lo_, hi_)` forward from its previous position if neither of its limits has decreased, which is always the case when `x0` increases with a constant bandwidth, and otherwise locates it by binary search.  Either way the cost is logarithmic in the number of observations, or proportional to the distance moved.
+  ///
+  /// @param[in] x0 Value of the first covariate.
+  inline void LocalFit::set_window(double x0) {
+    double lower = x0 - band_;
+    double upper = x0 + band_;
+    if(has_x0_ && lower >= lower_ && upper >= upper_) {
+      while(lo_ < n_obs_ && x_(lo_) <= lower) lo_++;
+      if(hi_ < lo_) hi_ = lo_;
+      while(hi_ < n_obs_ && x_(hi_) < upper) hi_++;
+    } else {
+      const double* xb = x_.data();
+      lo_ = std::upper_bound(xb, xb + n_obs_, lower) - xb;
+      hi_ = std::lower_bound(xb + lo_, xb + n_obs_, upper) - xb;
+    }
+    lower_ = lower;
+    upper_ = upper;
+    return;
+  }
+
+  /// Calculates the kernel weights of all observations with positive weight, followed by the columns of the design matrix.  With a single covariate in a window, every observation in the window is kept, such that the marginal transformations are read in place.  Otherwise, only those with positive weight are kept.
+  ///
+  /// @param[in] x0 Pointer to the covariate values.
+  /// @param[in] drop Index of an observation to leave out of the local likelihood, i.e., whose weight is set to zero.  Ignored if negative.
+  inline void LocalFit::set_point(const double* x0, int drop) {
+    wgt_.clear();
+    iwgt_.clear();
+    if(band_type_ == BandType::Variable) {
+      int k = knn_index(band_par_, n_obs_);
+      band_ = sorted_ ? knn_radius(x_.data(), n_obs_, x0[0], k) :
+        knn_radius(x_.data(), n_obs_, x0[0], k, dist_);
+    }
+    int lo = 0;
+    int hi = n_obs_;
+    if(window_) {
+      set_window(x0[0]);
+      lo = lo_;
+      hi = hi_;
+    }
+    for(int ii=lo; ii<hi; ii++) {
+      double w = kernel_weight(x_(ii), x0[0], band_, kernel_);
+      for(int kk=1; kk<n_cov_ && w > 0.0; kk++) {
+        w *= kernel_weight(xmat_(ii,kk), x0[kk], band_ * band_ratio_[kk],
+                           kernel_);
+      }
+      if(freq_) w *= freq_[ii];
+      if(contig_) {
+        wgt_.push_back(w);
+      } else if(w > 0.0) {
+        iwgt_.push_back(ii);
+        wgt_.push_back(w);
+      }
+    }
+    // design matrix: intercept, centered covariates, then products
+    int nw = wgt_.size();
+    xd_.resize(static_cast<std::size_t>(nw) * n_par_);
+    Map<MatrixXd> X(xd_.data(), nw, n_par_);
+    X.col(0).setOnes();
+    for(int kk=0; kk<n_cov_ && kk+1<n_par_; kk++) {
+      for(int jj=0; jj<nw; jj++) X(jj,kk+1) = xmat_(obs(jj),kk) - x0[kk];
+    }
+    for(int tt=n_cov_+1; tt<n_par_; tt++) {
+      X.col(tt) = X.col(parent_[tt]).cwiseProduct(X.col(var_[tt]+1));
+    }
+    for(int kk=0; kk<n_cov_; kk++) x0_[kk] = x0[kk];
+    has_x0_ = true;
+    if(drop >= 0) drop_obs(drop);
+    return;
+  }
+
+  /// @param[in] x0 Covariate value.  Requires a single covariate.
+  /// @param[in] drop Index of an observation to leave out of the local likelihood, i.e., whose weight is set to zero.  Ignored if negative.
+  inline void LocalFit::set_x0(double x0, int drop) {
+    if(n_cov_ != 1) {
+      throw std::invalid_argument("x0 must have one element per covariate.");
+    }
+    set_point(&x0, drop);
+    return;
+  }
+
+  /// @param[in] x0 Vector with one element per covariate.
+  /// @param[in] drop Index of an observation to leave out of the local likelihood, i.e., whose weight is set to zero.  Ignored if negative.
+  inline void LocalFit::set_x0(cRefVector_t<double>& x0, int drop) {
+    if(x0.size() != n_cov_) {
+      throw std::invalid_argument("x0 must have one element per covariate.");
+    }
+    set_point(x0.data(), drop);
+    return;
+  }
+
+  /// @param[in] ii Index of the observation.
+  ///
+  /// @return The row of the design matrix of observation `ii` at the current value of `x0`, or -1 if it does not have positive weight.
+  inline int LocalFit::active_index(int ii) const {
+    int jj = -1;
+    if(contig_) {
+      if(ii >= lo_ && ii < hi_) jj = ii - lo_;
+    } else {
+      std::vector<int>::const_iterator it =
+        std::lower_bound(iwgt_.begin(), iwgt_.end(), ii);
+      if(it != iwgt_.end() && *it == ii) jj = it - iwgt_.begin();
+    }
+    return jj;
+  }
+
+  /// For a fast approximation to the leave-one-out estimate from a fit with all observations, see `downdate()`.
+  ///
+  /// @param[in] ii Index of the observation.  Nothing is done if the observation does not have positive weight at the current value of `x0`.  With frequency weights, a single one of the `freq_ii` observations in row `ii` is left out.
+  inline void LocalFit::drop_obs(int ii) {
+    int jj = active_index(ii);
+    if(jj >= 0) {
+      if(freq_ && freq_[ii] > 1.0) {
+        wgt_[jj] *= (freq_[ii] - 1.0) / freq_[ii];
+      } else {
+        wgt_[jj] = 0.0;
+      }
+    }
+    return;
+  }
+
+  /// Fills `ld_buf_`, and optionally `d1_buf_` and `d2_buf_`, with the log-density of each observation with positive weight and its derivatives with respect to `eta`, which has already been calculated in `eta_buf_`.
+  ///
+  /// @param[in] deriv Whether to calculate the derivatives.
+  inline void LocalFit::eval_batch(bool deriv) {
+    int nw = wgt_.size();
+    ld_buf_.resize(nw);
+    const double* ut = utrans_.data() + lo_;
+    int stride = utrans_.outerStride();
+    if(!contig_) {
+      // gather observations
+      ut_buf_.resize(nw * n_trans_);
+      for(int kk=0; kk<n_trans_; kk++) {
+        for(int jj=0; jj<nw; jj++) {
+          ut_buf_[kk*nw + jj] = utrans_(iwgt_[jj], kk);
+        }
+      }
+      ut = ut_buf_.data();
+      stride = nw;
+    }
+    if(deriv) {
+      d1_buf_.resize(nw);
+      d2_buf_.resize(nw);
+      lpdf_eta_batch(ut, stride, eta_buf_.data(), nw, family_,
+                     ld_buf_.data(), d1_buf_.data(), d2_buf_.data());
+    } else {
+      lpdf_eta_batch(ut, stride, eta_buf_.data(), nw, family_,
+                     ld_buf_.data(), nullptr, nullptr);
+    }
+    return;
+  }
+
+  /// Fills `ld_buf_`, and optionally `d1_buf_` and `d2_buf_`, in the same way as `eval_batch()`, but with `Family<double>::lpdf_utrans()`, or with `Family<Jet>::lpdf_utrans()` for the derivatives.  The buffers are not set for observations with zero weight.
+  ///
+  /// @param[in] deriv Whether to calculate the derivatives.
+  template <template<class> class Family>
+  inline void LocalFit::eval_family(bool deriv) {
+    typedef Family<double> Copula;
+    typedef Family<Jet> CopulaJet;
+    int nw = wgt_.size();
+    ld_buf_.resize(nw);
+    if(deriv) {
+      d1_buf_.resize(nw);
+      d2_buf_.resize(nw);
+      Jet v[Copula::n_trans];
+      Jet nu(nu_);
+      for(int jj=0; jj<nw; jj++) {
+        if(wgt_[jj] == 0.0) continue;
+        int ii = obs(jj);
+        for(int kk=0; kk<Copula::n_trans; kk++) v[kk] = Jet(utrans_(ii,kk));
+        Jet lpdf = CopulaJet::lpdf_utrans(v,
+                                          CopulaJet::theta(Jet(eta_buf_[jj], 1.0)),
+                                          nu);
+        ld_buf_[jj] = lpdf.val;
+        d1_buf_[jj] = lpdf.d1;
+        d2_buf_[jj] = lpdf.d2;
+      }
+    } else {
+      double v[Copula::n_trans];
+      for(int jj=0; jj<nw; jj++) {
+        if(wgt_[jj] == 0.0) continue;
+        int ii = obs(jj);
+        for(int kk=0; kk<Copula::n_trans; kk++) v[kk] = utrans_(ii,kk);
+        ld_buf_[jj] = Copula::lpdf_utrans(v, Copula::theta(eta_buf_[jj]), nu_);
+      }
+    }
+    return;
+  }
+
+  /// Calculates `eta = X * beta` in `eta_buf_`, followed by the log-densities.
+  ///
+  /// @param[in] beta Local polynomial coefficients.
+  /// @param[in] deriv Whether to calculate the derivatives.
+  inline void LocalFit::eval_lpdf(const Coef_t& beta, bool deriv) {
+    int nw = wgt_.size();
+    eta_buf_.resize(nw);
+    Map<VectorXd>(eta_buf_.data(), nw).noalias() = design() * beta;
+    if(use_batch()) {
+      eval_batch(deriv);
+    } else {
+      EvalFamily fun = {this, deriv};
+      dispatch_family(family_, fun);
+    }
+    return;
+  }
+
+  inline double LocalFit::eval_nll(const Coef_t& beta) {
+    double nll = 0.0;
+    int nw = wgt_.size();
+    eval_lpdf(beta, false);
+    for(int jj=0; jj<nw; jj++) {
+      if(wgt_[jj] != 0.0) nll -= wgt_[jj] * ld_buf_[jj];
+    }
+    return nll;
+  }
+
+  /// The derivative buffers are overwritten with `-wgt * d1` and `-wgt * d2`, which are zero for observations with zero weight, after which the gradient is `X' * d1_buf_` and the Hessian is `X' * (d2_buf_ * X)`.
+  inline double LocalFit::eval_deriv(const Coef_t& beta) {
+    double nll = 0.0;
+    int nw = wgt_.size();
+    eval_lpdf(beta, true);
+    for(int jj=0; jj<nw; jj++) {
+      double w = wgt_[jj];
+      if(w == 0.0) {
+        d1_buf_[jj] = 0.0;
+        d2_buf_[jj] = 0.0;
+        continue;
+      }
+      nll -= w * ld_buf_[jj];
+      d1_buf_[jj] *= -w;
+      d2_buf_[jj] *= -w;
+    }
+    Map<const MatrixXd> X = design();
+    Map<const VectorXd> wd1(d1_buf_.data(), nw);
+    Map<const VectorXd> wd2(d2_buf_.data(), nw);
+    wx_.resize(xd_.size());
+    Map<MatrixXd> WX(wx_.data(), nw, n_par_);
+    WX.noalias() = wd2.asDiagonal() * X;
+    grad_.noalias() = X.transpose() * wd1;
+    hess_.noalias() = X.transpose() * WX;
+    return nll;
+  }
+
+  /// If the Hessian is not positive definite, a multiple of the identity is added to it until it is.
+  ///
+  /// @param[out] step Newton step, i.e., `-H^{-1} g`.
+  ///
+  /// @return The Newton decrement squared, i.e., `-g' * step`.
+  inline double LocalFit::newton_step(Coef_t& step) const {
+    Hess_t hmod(n_par_, n_par_);
+    LLT<Hess_t> llt(n_par_);
+    double lambda = 0.0;
+    double hscale = hess_.diagonal().cwiseAbs().maxCoeff();
+    if(hscale == 0.0) hscale = 1.0;
+    for(int jj=0; jj<50; jj++) {
+      hmod = hess_;
+      hmod.diagonal().array() += lambda;
+      llt.compute(hmod);
+      if(llt.info() == Success) break;
+      lambda = (lambda == 0.0) ? 1e-8 * hscale : 10.0 * lambda;
+    }
+    step = -llt.solve(grad_);
+    return -grad_.dot(step);
+  }
+
+  inline bool LocalFit::no_weight() const {
+    return std::none_of(wgt_.begin(), wgt_.end(),
+                        [](double w) { return w > 0.0; });
+  }
+
+  /// @param[out] beta Vector of length at least `n_par()`, the first `n_par()` elements of which are set to `NaN` and the remaining ones to zero.
+  ///
+  /// @return Convergence code 4.  The negative local log-likelihood and its gradient and Hessian are set to zero, such that the standard errors are `NaN`.
+  inline int LocalFit::fit_empty(RefVector_t<double> beta) {
+    niter_ = 0;
+    nll_ = 0.0;
+    grad_.setZero();
+    hess_.setZero();
+    beta.setZero();
+    beta.head(n_par_).setConstant(std::numeric_limits<double>::quiet_NaN());
+    return 4;
+  }
+
+  /// Uses a Newton method with backtracking line search.  The Newton step is calculated from the Cholesky factor of the Hessian.  If the Hessian is not positive definite, a multiple of the identity is added to it until it is.
+  ///
+  /// @param[in,out] beta On input, the starting value of the optimization.  On output, the local likelihood estimate.  Vector of length at least `n_par()`, the remaining elements of which are set to zero.  In particular, with a single covariate and `degree = 0`, `beta` can have length 2 with `beta[1]` set to zero.
+  ///
+  /// @return Convergence code:
+  /// - 0: Successful convergence.
+  /// - 1: Maximum number of iterations reached.
+  /// - 2: Non-finite value of the objective function or its derivatives.
+  /// - 3: Line search failed to decrease the objective function.
+  /// - 4: No observations with positive weight at `x0`, in which case the estimate is `NaN`.
+  inline int LocalFit::fit(RefVector_t<double> beta) {
+    if(no_weight()) return fit_empty(beta);
+    Coef_t beta_curr = beta.head(n_par_);
+    Coef_t beta_prop(n_par_);
+    Coef_t step(n_par_);
+    int code = 1;
+    nll_ = eval_deriv(beta_curr);
+    for(niter_ = 0; niter_ < maxit_; niter_++) {
+      if(!std::isfinite(nll_) || !grad_.allFinite() || !hess_.allFinite()) {
+        code = 2;
+        break;
+      }
+      double decr = newton_step(step);
+      if(.5 * decr <= reltol_ * (std::abs(nll_) + reltol_)) {
+        code = 0;
+        break;
+      }
+      // backtracking line search
+      double alpha = 1.0;
+      double nll_prop = 0.0;
+      bool decreased = false;
+      for(int jj=0; jj<30; jj++) {
+        beta_prop = beta_curr + alpha * step;
+        nll_prop = eval_nll(beta_prop);
+        if(std::isfinite(nll_prop) &&
+           (nll_prop <= nll_ - 1e-4 * alpha * decr)) {
+          decreased = true;
+          break;
+        }
+        alpha *= .5;
+      }
+      if(!decreased) {
+        code = 3;
+        break;
+      }
+      beta_curr = beta_prop;
+      nll_ = eval_deriv(beta_curr);
+    }
+    beta.setZero();
+    beta.head(n_par_) = beta_curr;
+    return code;
+  }
+
+  /// Leaving out observation `ii` changes the negative local log-likelihood by `w_ii * lpdf_ii(beta)`.  Rather than reevaluating the remaining observations, these are replaced by the quadratic expansion of the full-data likelihood at the last fit, the gradient and Hessian of which are already available, such that each Newton step only evaluates the log-density of observation `ii` and costs `O(p^3)` for `p` coefficients.  The first step is the same as the exact Newton step from the full-data estimate, and further steps converge to the minimum of the quadratic model.  The observation is left out as with `drop_obs()`, and `nll()`, `hessian()` and `std_err()` refer to the quadratic model at the leave-one-out estimate.
+  ///
+  /// @param[in] ii Index of the observation to leave out.
+  /// @param[in,out] beta On input, the estimate of the last call to `fit()`, with all observations at the current value of `x0`.  On output, the approximate leave-one-out estimate.  Unchanged if the observation does not have positive weight.
+  /// @param[in] nsteps Maximum number of Newton steps.
+  ///
+  /// @return Convergence code as for `fit()`, with 1 if the Newton steps did not converge within `nsteps`, and 4 if no other observation has positive weight.
+  inline int LocalFit::downdate(int ii, RefVector_t<double> beta,
+                                int nsteps) {
+    niter_ = 0;
+    int jj = active_index(ii);
+    if(jj < 0 || wgt_[jj] == 0.0) return 0;
+    double w = (freq_ && freq_[ii] > 1.0) ? wgt_[jj] / freq_[ii] : wgt_[jj];
+    drop_obs(ii);
+    if(no_weight()) return fit_empty(beta);
+    Coef_t xi = design().row(jj).transpose();
+    Coef_t beta_all = beta.head(n_par_);
+    Coef_t grad_all = grad_;
+    Hess_t hess_all = hess_;
+    double nll_all = nll_;
+    Jet v[4];
+    for(int kk=0; kk<n_trans_; kk++) v[kk] = Jet(utrans_(ii,kk));
+    Coef_t beta_curr = beta_all;
+    Coef_t diff(n_par_);
+    Coef_t step(n_par_);
+    int code = 1;
+    for(niter_ = 0; ; niter_++) {
+      // quadratic model of the full-data likelihood plus observation ii
+      Jet ld = lpdf_eta_utrans<Jet>(v, Jet(xi.dot(beta_curr), 1.0),
+                                    Jet(nu_), family_);
+      diff = beta_curr - beta_all;
+      grad_ = grad_all + hess_all * diff;
+      nll_ = nll_all + diff.dot(grad_all + .5 * (grad_ - grad_all)) +
+        w * ld.val;
+      grad_ += (w * ld.d1) * xi;
+      hess_ = hess_all + (w * ld.d2) * xi * xi.transpose();
+      if(!std::isfinite(nll_) || !grad_.allFinite() || !hess_.allFinite()) {
+        code = 2;
+        break;
+      }
+      double decr = newton_step(step);
+      if(.5 * decr <= reltol_ * (std::abs(nll_) + reltol_)) {
+        code = 0;
+        break;
+      }
+      if(niter_ == nsteps) break;
+      beta_curr += step;
+    }
+    beta.setZero();
+    beta.head(n_par_) = beta_curr;
+    return code;
+  }
+
+  /// @param[out] se Vector of length `n_par()` of standard errors.  These are `NaN` if the Hessian is not positive definite.
+  inline void LocalFit::std_err(RefVector_t<double> se) const {
+    LLT<Hess_t> llt(hess_);
+    if(llt.info() == Success) {
+      se = llt.solve(Hess_t::Identity(n_par_, n_par_)).diagonal().cwiseSqrt();
+    } else {
+      se.setConstant(std::numeric_limits<double>::quiet_NaN());
+    }
+    return;
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_LOCFIT_HPP
@@ -0,0 +1,129 @@
+/// @file loclik.hpp
+///
+/// @brief Local likelihood calculations for the **TMB** models.
+
+#ifndef LOCALCOP_LOCLIK_HPP
+#define LOCALCOP_LOCLIK_HPP
+
+#include "transform.hpp"
+
+namespace LocalCop {
+
+  /// Negative local log-likelihood for a given copula family.
+  ///
+  /// Computes
+  ///
+  /// ```
+  /// - sum_i wgt[i] * log_dCopula(y1[i], y2[i], X[i,] * beta)
+  /// ```
+  ///
+  /// where the copula density is on the calibration (eta) scale, and the columns of the design matrix `X` are the monomials of the local polynomial in the centered covariates, e.g., `X = cbind(1, xc)` for `degree = 1` with a single covariate `xc = x - x0`.  The responses `y1` and `y2` enter only through their marginal transformations, which do not depend on `beta` and so are calculated once per dataset rather than at every evaluation.
+  ///
+  /// @tparam Family Copula family class.  See `family.hpp`.
+  /// @param[in] utrans Matrix of marginal transformations of `y1` and `y2`, with one row per observation and `Family<Type>::n_trans` columns.  See `utrans()`.
+  /// @param[in] wgt Kernel weights.
+  /// @param[in] X Design matrix, with one row per observation and one column per element of `beta`.
+  /// @param[in] beta Vector of local likelihood coefficients.
+  /// @param[in] nu Second copula parameter.  Only used by the Student-t copula.
+  ///
+  /// @return Value of the negative local log-likelihood.
+  template <class Type, template<class> class Family>
+  Type loclik_nll(const matrix<Type>& utrans,
+                  const vector<Type>& wgt, const matrix<Type>& X,
+                  const vector<Type>& beta, const vector<Type>& nu) {
+    typedef Family<Type> Copula;
+    Type v[Copula::n_trans];
+    Type nll = Type(0.0);
+    for(int ii=0; ii<wgt.size(); ii++) {
+      for(int jj=0; jj<Copula::n_trans; jj++) v[jj] = utrans(ii,jj);
+      Type eta = Type(0.0);
+      for(int jj=0; jj<beta.size(); jj++) eta += X(ii,jj) * beta(jj);
+      nll -= wgt(ii) * Copula::lpdf_utrans(v, Copula::theta(eta),
+                                           Type(nu(ii)));
+    }
+    return nll;
+  }
+
+  /// Function object for dispatching `loclik_nll()` on the copula family.
+  template <class Type>
+  struct LoclikNll {
+    typedef Type result_type;
+    const matrix<Type>& utrans;
+    const vector<Type>& wgt;
+    const matrix<Type>& X;
+    const vector<Type>& beta;
+    const vector<Type>& nu;
+    template <template<class> class Family>
+    Type operator()(FamilyTag<Family>) const {
+      return loclik_nll<Type, Family>(utrans, wgt, X, beta, nu);
+    }
+  };
+
+  /// Negative local log-likelihood.
+  ///
+  /// Selects the instance of `loclik_nll<Type, Family>()` corresponding to `family` once, rather than at every observation.
+  ///
+  /// @param[in] utrans Matrix of marginal transformations of `y1` and `y2`, with one row per observation and `utrans_size(family)` columns.  See `utrans()`.
+  /// @param[in] wgt Kernel weights.
+  /// @param[in] X Design matrix, with one row per observation and one column per element of `beta`.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  /// @param[in] beta Vector of local likelihood coefficients.
+  /// @param[in] nu Second copula parameter.  Only used if `family = 2`.
+  ///
+  /// @return Value of the negative local log-likelihood.
+  template <class Type>
+  Type loclik_nll(const matrix<Type>& utrans,
+                  const vector<Type>& wgt, const matrix<Type>& X,
+                  int family, const vector<Type>& beta,
+                  const vector<Type>& nu) {
+    if(!valid_family(family) || (utrans.cols() != utrans_size(family))) {
+      Rf_error("Unknown copula family or wrong number of marginal transformations.");
+    }
+    if(X.cols() != beta.size()) {
+      Rf_error("X must have one column per element of beta.");
+    }
+    LoclikNll<Type> fun = {utrans, wgt, X, beta, nu};
+    return dispatch_family(family, fun);
+  }
+
+  /// Negative local log-likelihood of the Student-t copula with local degrees of freedom.
+  ///
+  /// Computes
+  ///
+  /// ```
+  /// - sum_i wgt[i] * log_dStudent(u1[i], u2[i], beta[0] + beta[1] * xc[i], nu[i]),
+  /// nu[i] = 2 + exp(gamma[0] + gamma[1] * xc[i])
+  /// ```
+  ///
+  /// such that both copula parameters are estimated jointly.  Since the Student-t quantiles now depend on the parameters, they are obtained with `qt_newton()` from quantiles cached at the current value of `nu`, rather than passed as marginal transformations.
+  ///
+  /// @param[in] u Matrix with columns `u1` and `u2`.
+  /// @param[in] ycache Matrix with columns `qt(u1, nu0)` and `qt(u2, nu0)`, where `nu0` is the value of `nu` at which the quantiles were last calculated.
+  /// @param[in] wgt Kernel weights.  Since these can be updated without retaping, rows of zero weight are evaluated as well, and must have finite quantiles in `ycache`.
+  /// @param[in] xc Centered covariates, i.e., `x - x0`.
+  /// @param[in] beta Vector of length 2 of local likelihood coefficients of `eta`.
+  /// @param[in] gamma Vector of length 2 of local likelihood coefficients of `log(nu - 2)`.
+  ///
+  /// @return Value of the negative local log-likelihood.
+  template <class Type>
+  Type loclik_student_nll(const matrix<Type>& u, const matrix<Type>& ycache,
+                          const vector<Type>& wgt, const vector<Type>& xc,
+                          const vector<Type>& beta,
+                          const vector<Type>& gamma) {
+    typedef Student<Type> Copula;
+    Type v[Copula::n_trans];
+    Type nll = Type(0.0);
+    for(int ii=0; ii<wgt.size(); ii++) {
+      Type eta = beta(0) + beta(1) * xc(ii);
+      Type nu = Type(2.0) + exp(gamma(0) + gamma(1) * xc(ii));
+      v[0] = qt_newton(u(ii,0), ycache(ii,0), nu);
+      v[1] = qt_newton(u(ii,1), ycache(ii,1), nu);
+      v[2] = dt(v[0], nu, 1) + dt(v[1], nu, 1);
+      nll -= wgt(ii) * Copula::lpdf_utrans(v, Copula::theta(eta), nu);
+    }
+    return nll;
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_LOCLIK_HPP
@@ -5,84 +5,141 @@
 
 // this is where RefVector_t etc. is defined
 #include "config.hpp"
+#include "transform.hpp"
+#include <vector>
 
-namespace LocalCop { 
+namespace LocalCop {
 
-/// Calculate negative log-likelihood calculations with censored data
-///
-/// Computes the negative of
-///
-/// ```
-/// sum_{i in uncensored} w[i] * log_dCopula(u1[i], u2[i], X[i,] * eta) + 
-/// sum_{i in first censored} w[i] * log_hCopula(u1[i], u2[i], X[i,] * eta) + 
-/// sum_{i in second censored} ... + 
-/// sum_{i in both censored} w[i] * log_pCopula(u1[i], u2[i], X[i,] * eta)
-/// ```
-///
-/// @param[in] u1 First uniform variable.
-/// @param[in] u2 Second uniform variable.
-/// @param[in] w Weight vector.
-/// @param[in] X Covariate matrix.
-/// @param[in] eta Calibration parameter matrix.
-/// @param[in] status_start Vector of length 4 giving the start locations for
-/// uncensored, first censored, second censored, and both censored.
-/// @param[in] status_length Same but giving length of each. 
-/// @param Copula Object containing the d/p/h function for the given `Family` copula,
-/// in the calibration scale (eta).
-///
-/// @return Value of the negative log-likelihood.
-///
-/// @todo Is it worth preallocating memory for the linear algebra operations?
-template <class Type, class Family>
-Type nll(cRefVector<Type>& u1, 
-         cRefVector<Type>& u2, 
-         cRefVector<Type>& w,
-         cRefMatrix<Type>& X,
-         cRefMatrix<Type>& eta,
-         const std::vector<int>& status_start,
-         const std::vector<int>& status_length
-         Family<Type>& Copula) {
-  Type res = Type(0.0);
-  // uncensored
-  int j=0;
-  if(status_length(j) > 0) {
-    res += (w.segment(status_start(j), status_length(j)) * Copula.dfun(
-      u1.segment(status_start(j), status_length(j)),
-      u2.segment(status_start(j), status_length(j)),
-      X.block(status_start(j), 0, status_length(j), X.cols()) * eta,
-      1 // give_log
-    )).sum();
-  }
-  // first censored
-  int j=1;
-  if(status_length(j) > 0) {
-    res += (w.segment(status_start(j), status_length(j)) * Copula.hfun(
-      u1.segment(status_start(j), status_length(j)),
-      u2.segment(status_start(j), status_length(j)),
-      X.block(status_start(j), 0, status_length(j), X.cols()) * eta,
-      1 // give_log
-    )).sum();
+  /// Censoring status of a pair of observations.
+  ///
+  /// The uniform variables are such that a censored observation `u` is only known to satisfy `U <= u`, e.g., `u = S(t)` for a right-censored survival time `t` with survival function `S()`.
+  enum CensStatus {
+    CENS_NONE = 0, ///< Neither variable is censored.
+    CENS_FIRST = 1, ///< Only `u1` is censored.
+    CENS_SECOND = 2, ///< Only `u2` is censored.
+    CENS_BOTH = 3 ///< Both variables are censored.
+  };
+
+  /// Log-likelihood contribution of a censored observation.
+  ///
+  /// @tparam Family Copula family class.  See `family.hpp`.
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] theta Copula parameter.  See `Family<Type>::theta()`.
+  /// @param[in] nu Second copula parameter.  Only used by the Student-t copula.
+  /// @param[in] status Censoring status.  See `CensStatus`.
+  ///
+  /// @return The log of the copula PDF if `status = CENS_NONE`, of `dC/du2` if `status = CENS_FIRST`, of `dC/du1` if `status = CENS_SECOND`, and of the copula CDF if `status = CENS_BOTH`.
+  template <class Type, template<class> class Family>
+  Type lcens(Type u1, Type u2, Type theta, Type nu, int status) {
+    typedef Family<Type> Copula;
+    if(status == CENS_NONE) {
+      return Copula::dfun(u1, u2, theta, nu, 1);
+    } else if(status == CENS_FIRST) {
+      return Copula::hfun2(u1, u2, theta, nu, 1);
+    } else if(status == CENS_SECOND) {
+      return Copula::hfun(u1, u2, theta, nu, 1);
+    } else {
+      return Copula::pfun(u1, u2, theta, nu, 1);
+    }
   }
-  // second censored
-  int j=2;
-  if(status_length(j) > 0) {
-    res += (w.segment(status_start(j), status_length(j)) * Copula.hfun(
-      u2.segment(status_start(j), status_length(j)), // switched u1 and u2
-      u1.segment(status_start(j), status_length(j)),
-      X.block(status_start(j), 0, status_length(j), X.cols()) * eta,
-      1 // give_log
-    )).sum();
+
+  /// Calculate negative log-likelihood calculations with censored data
+  ///
+  /// Computes the negative of
+  ///
+  /// ```
+  /// sum_{i in uncensored} w[i] * log_dCopula(u1[i], u2[i], X[i,] * beta) +
+  /// sum_{i in first censored} w[i] * log_h2Copula(u1[i], u2[i], X[i,] * beta) +
+  /// sum_{i in second censored} w[i] * log_hCopula(u1[i], u2[i], X[i,] * beta) +
+  /// sum_{i in both censored} w[i] * log_pCopula(u1[i], u2[i], X[i,] * beta)
+  /// ```
+  ///
+  /// where `log_hCopula(u1, u2, eta)` and `log_h2Copula(u1, u2, eta)` are the logs of the derivatives of the copula CDF with respect to `u1` and `u2`.  The data must be sorted by censoring status, such that the four sums are calculated in a single pass, with `X[i,] * beta` computed one observation at a time.  Observations with zero weight are skipped.
+  ///
+  /// @tparam Family Copula family class.  See `family.hpp`.  If `Family<Type>::has_pfun` is `false`, requires `status_length[3] = 0`.
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] w Weight vector.
+  /// @param[in] X Covariate matrix.
+  /// @param[in] beta Vector of regression coefficients of the calibration parameter, i.e., `eta = X * beta`.
+  /// @param[in] status_start Vector of length 4 giving the start locations for
+  /// uncensored, first censored, second censored, and both censored.
+  /// @param[in] status_length Same but giving length of each.
+  /// @param[in] nu Second copula parameter.  Only used by the Student-t copula.
+  ///
+  /// @return Value of the negative log-likelihood.
+  template <class Type, template<class> class Family>
+  Type nll(cRefVector_t<Type>& u1,
+           cRefVector_t<Type>& u2,
+           cRefVector_t<Type>& w,
+           cRefMatrix_t<Type>& X,
+           cRefVector_t<Type>& beta,
+           const std::vector<int>& status_start,
+           const std::vector<int>& status_length,
+           Type nu) {
+    typedef Family<Type> Copula;
+    Type res = Type(0.0);
+    for(int j=CENS_NONE; j<=CENS_BOTH; j++) {
+      int end = status_start[j] + status_length[j];
+      for(int i=status_start[j]; i<end; i++) {
+        if(w(i) == Type(0.0)) continue;
+        Type theta = Copula::theta(X.row(i).dot(beta));
+        res += w(i) * lcens<Type, Family>(u1(i), u2(i), theta, nu, j);
+      }
+    }
+    return -res;
   }
-  // both censored
-  int j=3;
-  if(status_length(j) > 0) {
-    res += (w.segment(status_start(j), status_length(j)) * Copula.pfun(
-      u1.segment(status_start(j), status_length(j)),
-      u2.segment(status_start(j), status_length(j)),
-      X.block(status_start(j), 0, status_length(j), X.cols()) * eta,
-      1 // give_log
-    )).sum();
+
+  /// Function object for dispatching `nll()` on the copula family.
+  template <class Type>
+  struct CensNll {
+    typedef Type result_type;
+    cRefVector_t<Type>& u1;
+    cRefVector_t<Type>& u2;
+    cRefVector_t<Type>& w;
+    cRefMatrix_t<Type>& X;
+    cRefVector_t<Type>& beta;
+    const std::vector<int>& status_start;
+    const std::vector<int>& status_length;
+    Type nu;
+    template <template<class> class Family>
+    Type operator()(FamilyTag<Family>) const {
+      return nll<Type, Family>(u1, u2, w, X, beta,
+                               status_start, status_length, nu);
+    }
+  };
+
+  /// Calculate negative log-likelihood calculations with censored data
+  ///
+  /// Selects the instance of `nll<Type, Family>()` corresponding to `family` once, rather than at every observation.
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] w Weight vector.
+  /// @param[in] X Covariate matrix.
+  /// @param[in] beta Vector of regression coefficients of the calibration parameter, i.e., `eta = X * beta`.
+  /// @param[in] status_start Vector of length 4 giving the start locations for
+  /// uncensored, first censored, second censored, and both censored.
+  /// @param[in] status_length Same but giving length of each.
+  /// @param[in] family Copula family.  See `ConvertPar()`.  If `has_pcopula(family)` is `false`, requires `status_length[3] = 0`.
+  /// @param[in] nu Second copula parameter.  Only used if `family = 2`.
+  ///
+  /// @return Value of the negative log-likelihood.
+  template <class Type>
+  Type nll(cRefVector_t<Type>& u1,
+           cRefVector_t<Type>& u2,
+           cRefVector_t<Type>& w,
+           cRefMatrix_t<Type>& X,
+           cRefVector_t<Type>& beta,
+           const std::vector<int>& status_start,
+           const std::vector<int>& status_length,
+           int family, Type nu) {
+    CensNll<Type> fun = {u1, u2, w, X, beta,
+                         status_start, status_length, nu};
+    return dispatch_family(family, fun);
   }
-  return -res;
-}
-}  
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_NLL_HPP
@@ -0,0 +1,314 @@
+/// @file online.hpp
+///
+/// @brief Online local likelihood estimation for streaming observations.
+///
+/// The local likelihood is fit on a fixed grid of covariate values `x0` to a set of observations which grows as new observations arrive, and shrinks as old ones expire from a sliding time window.  With a compact kernel, an observation at `x` only enters the local likelihood at the grid points with `abs(x - x0) < band`, so only these need to be refit when it arrives or expires.  The observations are stored in buckets between consecutive grid points, each of which is in order of arrival, such that adding an observation costs a binary search, expiring one costs constant time, and the local likelihood at a grid point is assembled from the buckets within its bandwidth.  The grid points affected by a batch of updates are then refit by taking a few Newton steps from their previous estimates, which are usually very close to the new optimum.  Each refresh thus costs time proportional to the number of affected grid points times the number of observations within their bandwidth, rather than to the total number of observations.
+
+#ifndef LOCALCOP_ONLINE_HPP
+#define LOCALCOP_ONLINE_HPP
+
+#include "locfit.hpp"
+#include "threads.hpp"
+#include <vector>
+#include <deque>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace LocalCop {
+
+  /// Control parameters of `OnlineFit::update()`.
+  struct OnlineControl {
+    /// Maximum number of Newton iterations for grid points which have not been fit before, or whose previous fit failed.
+    int maxit = 100;
+    /// Maximum number of Newton iterations for grid points which are refit from their previous estimate.
+    int nsteps = 3;
+    /// Relative tolerance of the Newton iterations.
+    double reltol = 1e-10;
+    /// Whether to use closed-form derivatives of the log-density where available.  See `LocalFit::set_analytic()`.
+    bool analytic = true;
+    /// Number of threads.  See `get_nthreads()`.
+    int nthreads = 1;
+  };
+
+  /// Online local likelihood estimation on a fixed grid of covariate values.
+  class OnlineFit {
+  private:
+    // observations with x0[b-1] <= x < x0[b], in order of arrival
+    struct Bucket {
+      std::vector<double> x;
+      std::vector<double> utrans; // utrans_size(family) values per observation
+      std::size_t head = 0; // number of expired observations at the front
+    };
+    VectorXd x0_;
+    int nx_;
+    int family_;
+    double nu_;
+    int degree_;
+    Kernel kernel_;
+    double band_;
+    Vector2d eta_; // default starting value
+    int n_trans_;
+    std::vector<Bucket> bucket_;
+    std::deque<std::pair<double, int> > fifo_; // time and bucket of each observation
+    std::vector<int> blo_; // first bucket of each grid point
+    std::vector<int> bhi_; // last bucket of each grid point (inclusive)
+    std::vector<char> dirty_; // whether grid point needs to be refit
+    std::vector<char> fitted_; // whether grid point has a previous estimate
+    std::vector<int> nbuck_; // number of observations in the buckets of each grid point
+    // per-thread workspace for the observations of a grid point
+    std::vector<VectorXd> xbuf_;
+    std::vector<MatrixXd> ubuf_;
+    // results
+    MatrixXd coef_;
+    MatrixXd se_;
+    VectorXd nll_;
+    std::vector<int> code_;
+    std::vector<int> niter_;
+    std::vector<int> nlocal_;
+    /// Bucket containing covariate value `x`.
+    int bucket_of(double x) const {
+      return std::upper_bound(x0_.data(), x0_.data() + nx_, x) - x0_.data();
+    }
+    /// Flag the grid points whose local likelihood contains an observation at `x`.
+    void set_dirty(double x);
+  public:
+    /// Constructor.
+    OnlineFit(cRefVector_t<double>& x0, int family, double nu, int degree,
+              Kernel kernel, double band, const Vector2d& eta);
+    /// Add observations.
+    void add(cRefVector_t<double>& u1, cRefVector_t<double>& u2,
+             cRefVector_t<double>& x, cRefVector_t<double>& time);
+    /// Remove the observations which arrived before a given time.
+    int expire(double time);
+    /// Flag every grid point to be refit from scratch at the next update.
+    void reset();
+    /// Refit the local likelihood at the grid points affected by the observations added or removed since the last update.
+    int update(const OnlineControl& ctrl);
+    /// Number of observations currently in the window.
+    int n_obs() const { return fifo_.size(); }
+    /// Number of grid points waiting to be refit.
+    int n_dirty() const {
+      return std::count(dirty_.begin(), dirty_.end(), 1);
+    }
+    /// Grid of covariate values.
+    const VectorXd& x0() const { return x0_; }
+    /// A `2 x nx` matrix of local likelihood estimates of `beta`.
+    const MatrixXd& coef() const { return coef_; }
+    /// A `2 x nx` matrix of standard errors.
+    const MatrixXd& se() const { return se_; }
+    /// Negative local log-likelihood at each grid point.
+    const VectorXd& nll() const { return nll_; }
+    /// Convergence code at each grid point.  See `LocalFit::fit()`.
+    const std::vector<int>& convergence() const { return code_; }
+    /// Number of Newton iterations at the last refit of each grid point.
+    const std::vector<int>& niter() const { return niter_; }
+    /// Number of observations with positive weight at each grid point.
+    const std::vector<int>& n_local() const { return nlocal_; }
+  };
+
+  /// @param[in] x0 Sorted vector of covariate values at which to fit the local likelihood.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  /// @param[in] nu Second copula parameter.
+  /// @param[in] degree Degree of the local polynomial: 0 or 1.
+  /// @param[in] kernel Kernel function.  With a kernel which does not have compact support, every observation affects every grid point.
+  /// @param[in] band Kernel bandwidth.
+  /// @param[in] eta Starting value of `beta` at grid points which have not been fit before.
+  inline OnlineFit::OnlineFit(cRefVector_t<double>& x0, int family, double nu,
+                              int degree, Kernel kernel, double band,
+                              const Vector2d& eta) :
+    x0_(x0), family_(family), nu_(nu), degree_(degree),
+    kernel_(kernel), band_(band), eta_(eta) {
+    nx_ = x0_.size();
+    if(nx_ == 0) throw std::invalid_argument("x0 must not be empty.");
+    if(!std::is_sorted(x0_.data(), x0_.data() + nx_)) {
+      throw std::invalid_argument("x0 must be sorted.");
+    }
+    if(degree_ != 0 && degree_ != 1) {
+      throw std::invalid_argument("degree must be 0 or 1.");
+    }
+    if(!(band_ > 0.0)) throw std::invalid_argument("band must be positive.");
+    if(degree_ == 0) eta_(1) = 0.0;
+    n_trans_ = utrans_size(family_);
+    bucket_.resize(nx_ + 1);
+    blo_.resize(nx_);
+    bhi_.resize(nx_);
+    for(int jj=0; jj<nx_; jj++) {
+      if(kernel_compact(kernel_)) {
+        blo_[jj] = bucket_of(x0_(jj) - band_);
+        bhi_[jj] = bucket_of(x0_(jj) + band_);
+      } else {
+        blo_[jj] = 0;
+        bhi_[jj] = nx_;
+      }
+    }
+    dirty_.assign(nx_, 0);
+    fitted_.assign(nx_, 0);
+    coef_.resize(2, nx_);
+    for(int jj=0; jj<nx_; jj++) coef_.col(jj) = eta_;
+    se_ = MatrixXd::Constant(2, nx_, std::numeric_limits<double>::quiet_NaN());
+    nll_ = VectorXd::Zero(nx_);
+    code_.assign(nx_, 0);
+    niter_.assign(nx_, 0);
+    nlocal_.assign(nx_, 0);
+  }
+
+  /// @param[in] x Covariate value.
+  inline void OnlineFit::set_dirty(double x) {
+    int jlo = 0;
+    int jhi = nx_;
+    if(kernel_compact(kernel_)) {
+      const double* xb = x0_.data();
+      jlo = std::upper_bound(xb, xb + nx_, x - band_) - xb;
+      jhi = std::lower_bound(xb + jlo, xb + nx_, x + band_) - xb;
+    }
+    std::fill(dirty_.begin() + jlo, dirty_.begin() + std::max(jlo, jhi), 1);
+    return;
+  }
+
+  /// The marginal transformations of the new observations are calculated once, when they are added.
+  ///
+  /// @param[in] u1 Vector of first uniform variables.
+  /// @param[in] u2 Vector of second uniform variables.
+  /// @param[in] x Vector of covariates.
+  /// @param[in] time Vector of arrival times, which must be nondecreasing and no earlier than those of the observations already added.
+  inline void OnlineFit::add(cRefVector_t<double>& u1,
+                             cRefVector_t<double>& u2,
+                             cRefVector_t<double>& x,
+                             cRefVector_t<double>& time) {
+    int n = x.size();
+    if(u1.size() != n || u2.size() != n || time.size() != n) {
+      throw std::invalid_argument("u1, u2, x, and time must have the same length.");
+    }
+    double tprev = fifo_.empty() ? -std::numeric_limits<double>::infinity() :
+      fifo_.back().first;
+    for(int ii=0; ii<n; ii++) {
+      if(!(time(ii) >= tprev)) {
+        throw std::invalid_argument("time must be nondecreasing.");
+      }
+      tprev = time(ii);
+    }
+    double v[4];
+    for(int ii=0; ii<n; ii++) {
+      int b = bucket_of(x(ii));
+      Bucket& bk = bucket_[b];
+      utrans<double>(u1(ii), u2(ii), nu_, family_, v);
+      bk.x.push_back(x(ii));
+      bk.utrans.insert(bk.utrans.end(), v, v + n_trans_);
+      fifo_.emplace_back(time(ii), b);
+      set_dirty(x(ii));
+    }
+    return;
+  }
+
+  /// @param[in] time Observations with arrival time strictly less than `time` are removed.
+  ///
+  /// @return The number of observations removed.
+  inline int OnlineFit::expire(double time) {
+    int nexp = 0;
+    while(!fifo_.empty() && fifo_.front().first < time) {
+      Bucket& bk = bucket_[fifo_.front().second];
+      set_dirty(bk.x[bk.head]);
+      bk.head++;
+      if(2 * bk.head >= bk.x.size()) {
+        // compact the bucket once half of it has expired
+        bk.x.erase(bk.x.begin(), bk.x.begin() + bk.head);
+        bk.utrans.erase(bk.utrans.begin(),
+                        bk.utrans.begin() + bk.head * n_trans_);
+        bk.head = 0;
+      }
+      fifo_.pop_front();
+      nexp++;
+    }
+    return nexp;
+  }
+
+  inline void OnlineFit::reset() {
+    dirty_.assign(nx_, 1);
+    fitted_.assign(nx_, 0);
+    return;
+  }
+
+  /// Each grid point to be refit gathers the observations in the buckets within its bandwidth, and fits the local likelihood to them starting from its previous estimate with at most `ctrl.nsteps` Newton iterations, or from `eta` with at most `ctrl.maxit` if it has not been fit successfully before.  As in `fit_grid()` with `loo_steps`, running out of Newton iterations in a refit is not considered a failure, the previous estimate being close to the optimum.  Grid points without any observations with positive weight are not fit, and have convergence code `4` and `NaN` estimates as in `LocalFit::fit()`.
+  ///
+  /// @param[in] ctrl Control parameters.
+  ///
+  /// @return The number of grid points which were refit.
+  inline int OnlineFit::update(const OnlineControl& ctrl) {
+    std::vector<int> ind;
+    int mmax = 0;
+    nbuck_.assign(nx_, 0);
+    for(int jj=0; jj<nx_; jj++) {
+      if(!dirty_[jj]) continue;
+      ind.push_back(jj);
+      for(int b=blo_[jj]; b<=bhi_[jj]; b++) {
+        nbuck_[jj] += bucket_[b].x.size() - bucket_[b].head;
+      }
+      mmax = std::max(mmax, nbuck_[jj]);
+    }
+    int nfit = ind.size();
+    int nthreads = get_nthreads(ctrl.nthreads, nfit);
+    // workspace is kept between updates, and only grows
+    if(static_cast<int>(xbuf_.size()) < nthreads) {
+      xbuf_.resize(nthreads);
+      ubuf_.resize(nthreads);
+    }
+    for(int it=0; it<nthreads; it++) {
+      if(xbuf_[it].size() < mmax) {
+        xbuf_[it].resize(mmax);
+        ubuf_[it].resize(mmax, n_trans_);
+      }
+    }
+    int npar = degree_ + 1;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    parallel_for(nfit, nthreads, [&](int kk, int it) {
+      int jj = ind[kk];
+      // gather the observations within the bandwidth of x0[jj]
+      int m = nbuck_[jj];
+      VectorXd& xl = xbuf_[it];
+      MatrixXd& ul = ubuf_[it];
+      int ii = 0;
+      for(int b=blo_[jj]; b<=bhi_[jj]; b++) {
+        const Bucket& bk = bucket_[b];
+        for(std::size_t ib=bk.head; ib<bk.x.size(); ib++, ii++) {
+          xl(ii) = bk.x[ib];
+          for(int tt=0; tt<n_trans_; tt++) {
+            ul(ii,tt) = bk.utrans[ib * n_trans_ + tt];
+          }
+        }
+      }
+      cRefVector_t<double> xm(xl.head(m));
+      cRefMatrix_t<double> um(ul.topRows(m));
+      LocalFit lf(um, xm, family_, nu_, degree_, kernel_, band_);
+      lf.set_analytic(ctrl.analytic);
+      lf.set_x0(x0_(jj));
+      nlocal_[jj] = lf.n_active();
+      if(lf.n_active() == 0) {
+        coef_.col(jj).setConstant(nan);
+        se_.col(jj).setConstant(nan);
+        nll_(jj) = 0.0;
+        code_[jj] = 4;
+        niter_[jj] = 0;
+        fitted_[jj] = 0;
+        return;
+      }
+      bool refit = fitted_[jj];
+      if(!refit) coef_.col(jj) = eta_;
+      lf.set_control(refit ? ctrl.nsteps : ctrl.maxit, ctrl.reltol);
+      int code = lf.fit(coef_.col(jj));
+      if(refit && code == 1) code = 0;
+      code_[jj] = code;
+      niter_[jj] = lf.niter();
+      nll_(jj) = lf.nll();
+      se_.col(jj).setZero();
+      lf.std_err(se_.col(jj).head(npar));
+      fitted_[jj] = (code == 0);
+    });
+    dirty_.assign(nx_, 0);
+    return nfit;
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_ONLINE_HPP
@@ -0,0 +1,288 @@
+/// @file predict.hpp
+///
+/// @brief Prediction from a local likelihood fit on a grid of covariate values.
+///
+/// A `GridModel` stores the estimates of `eta` on a grid `x0`, along with their local slopes when the local polynomial has degree one, and evaluates or simulates from the conditional copula at new covariate values.  Between grid points, `eta` is interpolated by the cubic Hermite polynomial which matches the estimates and slopes at both ends of the interval, or linearly if the slopes are not available.  The family is selected once per call, after which a single loop over the new observations interpolates `eta` and evaluates the requested function of the family class.
+
+#ifndef LOCALCOP_PREDICT_HPP
+#define LOCALCOP_PREDICT_HPP
+
+#include "config.hpp"
+#include "family.hpp"
+#include "threads.hpp"
+#include "rng.hpp"
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace LocalCop {
+
+  /// Function of the conditional copula to predict.
+  enum PredictType {
+    PRED_ETA = 0, ///< Dependence parameter on the `eta` scale.
+    PRED_PAR = 1, ///< Copula parameter, as in **VineCopula**.
+    PRED_TAU = 2, ///< Kendall's tau.
+    PRED_PDF = 3, ///< Copula PDF.
+    PRED_HFUN = 4, ///< Partial derivative of the copula CDF with respect to `u1`.
+    PRED_HFUN2 = 5, ///< Partial derivative of the copula CDF with respect to `u2`.
+    PRED_CDF = 6, ///< Copula CDF.
+    PRED_HINV = 7 ///< Inverse of `PRED_HFUN` with respect to `u2`.  See `copula_hinv()`.
+  };
+
+  /// Local likelihood fit on a grid of covariate values.
+  class GridModel {
+  private:
+    std::vector<double> x0_;
+    std::vector<double> eta_;
+    std::vector<double> slope_; // empty if not available
+    std::vector<double> nu_; // length 1 or length(x0)
+    int family_;
+
+    // evaluate the conditional copula at observations [start, end)
+    struct Predict {
+      typedef int result_type;
+      const GridModel& model;
+      PredictType type;
+      const double* x;
+      const double* u1;
+      const double* u2;
+      int give_log;
+      int rule;
+      double* out;
+      int start;
+      int end;
+      template <template<class> class Family>
+      int operator()(FamilyTag<Family>) const {
+        typedef Family<double> Copula;
+        const double NaN = std::numeric_limits<double>::quiet_NaN();
+        for(int ii=start; ii<end; ii++) {
+          double eta, nu;
+          if(!model.interp(x[ii], rule, eta, nu)) {
+            out[ii] = NaN;
+            continue;
+          }
+          if(type == PRED_ETA) {
+            out[ii] = eta;
+            continue;
+          }
+          double theta = Copula::theta(eta);
+          if(type == PRED_PAR) {
+            out[ii] = Copula::theta_par(theta);
+          } else if(type == PRED_TAU) {
+            out[ii] = Copula::tau(theta);
+          } else if(type == PRED_PDF) {
+            out[ii] = Copula::dfun(u1[ii], u2[ii], theta, nu, give_log);
+          } else if(type == PRED_HFUN) {
+            out[ii] = Copula::hfun(u1[ii], u2[ii], theta, nu, give_log);
+          } else if(type == PRED_HFUN2) {
+            out[ii] = Copula::hfun2(u1[ii], u2[ii], theta, nu, give_log);
+          } else if(type == PRED_CDF) {
+            out[ii] = Copula::pfun(u1[ii], u2[ii], theta, nu, give_log);
+          } else {
+            out[ii] = Copula::hinv(u2[ii], u1[ii], theta, nu);
+          }
+        }
+        return 0;
+      }
+    };
+
+    // simulate rows [start, end) of the output
+    struct Simulate {
+      typedef int result_type;
+      const GridModel& model;
+      const double* x;
+      int n;
+      int rule;
+      uint64_t seed;
+      int stream;
+      double* u1;
+      double* u2;
+      int start;
+      int end;
+      template <template<class> class Family>
+      int operator()(FamilyTag<Family>) const {
+        typedef Family<double> Copula;
+        const double NaN = std::numeric_limits<double>::quiet_NaN();
+        RngStream rng(seed, stream);
+        double eta = NaN, nu = NaN, theta = NaN;
+        bool ok = false;
+        int ix = -1;
+        for(int ii=start; ii<end; ii++) {
+          if(ii / n != ix) {
+            ix = ii / n;
+            ok = model.interp(x[ix], rule, eta, nu);
+            if(ok) theta = Copula::theta(eta);
+          }
+          // draw both uniforms even if not used, to keep the stream aligned
+          double v1 = rng.unif();
+          double p = rng.unif();
+          if(ok) {
+            u1[ii] = v1;
+            u2[ii] = Copula::hinv(p, v1, theta, nu);
+          } else {
+            u1[ii] = NaN;
+            u2[ii] = NaN;
+          }
+        }
+        return 0;
+      }
+    };
+
+  public:
+    /// Constructor.
+    ///
+    /// @param[in] x0 Sorted vector of covariate values at which the local likelihood was fit.
+    /// @param[in] beta Matrix with `length(x0)` rows of local coefficient estimates.  The first column is `eta`, and the second, if present, is its local slope.
+    /// @param[in] nu Second copula parameter.  Vector of length 1 or `length(x0)`, in which case it is interpolated linearly.
+    /// @param[in] family Copula family.  See `ConvertPar()`.
+    GridModel(cRefVector_t<double>& x0, cRefMatrix_t<double>& beta,
+              cRefVector_t<double>& nu, int family) : family_(family) {
+      int nx = x0.size();
+      if(nx == 0) throw std::invalid_argument("x0 must not be empty.");
+      for(int ii=1; ii<nx; ii++) {
+        if(x0(ii) < x0(ii-1)) throw std::invalid_argument("x0 must be sorted.");
+      }
+      if(beta.rows() != nx || beta.cols() < 1 || beta.cols() > 2) {
+        throw std::invalid_argument("beta must have length(x0) rows and 1 or 2 columns.");
+      }
+      if(nu.size() != 1 && nu.size() != nx) {
+        throw std::invalid_argument("nu must have length 1 or length(x0).");
+      }
+      if(!valid_family(family)) throw std::invalid_argument("Unsupported family.");
+      x0_.assign(x0.data(), x0.data() + nx);
+      eta_.resize(nx);
+      for(int ii=0; ii<nx; ii++) eta_[ii] = beta(ii,0);
+      if(beta.cols() == 2) {
+        slope_.resize(nx);
+        for(int ii=0; ii<nx; ii++) slope_[ii] = beta(ii,1);
+      }
+      nu_.assign(nu.data(), nu.data() + nu.size());
+    }
+
+    /// Interpolate `eta` and `nu` at a covariate value.
+    ///
+    /// @param[in] x Covariate value.
+    /// @param[in] rule How to treat values of `x` outside `range(x0)`, as in `stats::approx()`: `1` returns `false`, and `2` uses the value at the closest end of `x0`.
+    /// @param[out] eta Interpolated value of `eta`.
+    /// @param[out] nu Interpolated value of `nu`.
+    ///
+    /// @return Whether `eta` and `nu` are defined at `x`.
+    bool interp(double x, int rule, double& eta, double& nu) const {
+      int nx = x0_.size();
+      if(!(x >= x0_[0] && x <= x0_[nx-1])) {
+        if(rule != 2 || x != x) return false;
+        int ii = (x < x0_[0]) ? 0 : nx-1;
+        eta = eta_[ii];
+        nu = nu_[nu_.size() == 1 ? 0 : ii];
+        return true;
+      }
+      // interval x0[ii] <= x <= x0[ii+1]
+      int ii = std::upper_bound(x0_.begin(), x0_.end(), x) - x0_.begin() - 1;
+      if(ii >= nx-1) ii = nx-1;
+      double h = (ii < nx-1) ? x0_[ii+1] - x0_[ii] : 0.0;
+      if(h <= 0.0) {
+        eta = eta_[ii];
+        nu = nu_[nu_.size() == 1 ? 0 : ii];
+        return true;
+      }
+      double t = (x - x0_[ii]) / h;
+      if(slope_.size()) {
+        // cubic Hermite basis
+        double t1 = 1.0 - t;
+        eta = (1.0 + 2.0 * t) * t1 * t1 * eta_[ii] +
+          t * t1 * t1 * h * slope_[ii] +
+          t * t * (3.0 - 2.0 * t) * eta_[ii+1] -
+          t * t * t1 * h * slope_[ii+1];
+      } else {
+        eta = eta_[ii] + t * (eta_[ii+1] - eta_[ii]);
+      }
+      if(nu_.size() == 1) {
+        nu = nu_[0];
+      } else {
+        nu = nu_[ii] + t * (nu_[ii+1] - nu_[ii]);
+      }
+      return true;
+    }
+
+    /// Evaluate the conditional copula at new observations.
+    ///
+    /// @param[in] type Function to evaluate.  See `PredictType`.
+    /// @param[in] x Vector of covariate values.
+    /// @param[in] u1 Vector of first uniform variables of the same length as `x`.  Not used for `PRED_ETA`, `PRED_PAR`, and `PRED_TAU`, in which case it can have length zero.
+    /// @param[in] u2 Vector of second uniform variables of the same length as `x`, or of probabilities for `PRED_HINV`.  Not used for `PRED_ETA`, `PRED_PAR`, and `PRED_TAU`.
+    /// @param[in] give_log Whether to return the PDF, h-functions, or CDF on the log scale.
+    /// @param[in] rule See `interp()`.  Values of `x` at which `eta` is not defined give `NaN`.
+    /// @param[in] nthreads Number of threads.  See `get_nthreads()`.
+    /// @param[out] out Vector of the same length as `x`.
+    void predict(PredictType type, cRefVector_t<double>& x,
+                 cRefVector_t<double>& u1, cRefVector_t<double>& u2,
+                 int give_log, int rule, int nthreads,
+                 RefVector_t<double> out) const {
+      int n = x.size();
+      bool need_u = !(type == PRED_ETA || type == PRED_PAR || type == PRED_TAU);
+      if(need_u && (u1.size() != n || u2.size() != n)) {
+        throw std::invalid_argument("u1, u2, and x must have the same length.");
+      }
+      if(out.size() != n) throw std::invalid_argument("out must have the same length as x.");
+      const int chunk = 4096;
+      int ntasks = (n + chunk - 1) / chunk;
+      nthreads = get_nthreads(nthreads, ntasks);
+      parallel_for(ntasks, nthreads, [&](int task, int /* thread */) {
+        int start = task * chunk;
+        Predict fun = {*this, type, x.data(),
+                       need_u ? u1.data() : nullptr,
+                       need_u ? u2.data() : nullptr,
+                       give_log, rule, out.data(),
+                       start, std::min(start + chunk, n)};
+        dispatch_family(family_, fun);
+      });
+      return;
+    }
+
+    /// Simulate from the conditional copula at new covariate values.
+    ///
+    /// For each row of the output, `u1` is a standard uniform and `u2 = Copula::hinv(p, u1, theta, nu)` for an independent standard uniform `p`.  The rows are split into blocks of fixed size, each of which draws from its own `RngStream`, such that the result only depends on `seed` and not on `nthreads`.
+    ///
+    /// @param[in] x Vector of covariate values.
+    /// @param[in] n Number of draws at each element of `x`.
+    /// @param[in] seed Seed of the random number streams.
+    /// @param[in] rule See `interp()`.  Values of `x` at which `eta` is not defined give `NaN`.
+    /// @param[in] nthreads Number of threads.  See `get_nthreads()`.
+    /// @param[out] u Matrix with `n * length(x)` rows and 2 columns, the `n` draws at `x[i]` being in rows `i*n, ..., i*n + n-1`.
+    void simulate(cRefVector_t<double>& x, int n, uint64_t seed,
+                  int rule, int nthreads, RefMatrix_t<double> u) const {
+      if(n < 0) throw std::invalid_argument("n must be nonnegative.");
+      int nout = n * x.size();
+      if(u.rows() != nout || u.cols() != 2) {
+        throw std::invalid_argument("u must have n * length(x) rows and 2 columns.");
+      }
+      const int chunk = 4096;
+      int ntasks = (nout + chunk - 1) / chunk;
+      nthreads = get_nthreads(nthreads, ntasks);
+      double* u1 = u.col(0).data();
+      double* u2 = u.col(1).data();
+      parallel_for(ntasks, nthreads, [&](int task, int /* thread */) {
+        int start = task * chunk;
+        Simulate fun = {*this, x.data(), n, rule, seed, task, u1, u2,
+                        start, std::min(start + chunk, nout)};
+        dispatch_family(family_, fun);
+      });
+      return;
+    }
+
+    /// Number of grid points.
+    int size() const {
+      return x0_.size();
+    }
+
+    /// Whether `eta` is interpolated with its local slopes.
+    bool has_slope() const {
+      return slope_.size() > 0;
+    }
+
+  };
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_PREDICT_HPP
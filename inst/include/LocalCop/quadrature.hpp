@@ -0,0 +1,33 @@
+/// @file quadrature.hpp
+///
+/// @brief Fixed-abscissa quadrature rules.
+///
+/// The bivariate normal and Student-t CDFs are one-dimensional integrals which are evaluated with the same rule at every observation, such that the computation is a fixed sequence of operations which can be recorded on an AD tape and vectorized over observations.
+
+#ifndef LOCALCOP_QUADRATURE_HPP
+#define LOCALCOP_QUADRATURE_HPP
+
+namespace LocalCop {
+
+  /// 20-point Gauss-Legendre rule on `(-1, 1)`.
+  ///
+  /// The rule is symmetric, so only the negative abscissae `x` are stored, i.e., the abscissae are `x` and `-x`, both with weights `w`.  The values are those of Genz (2004), "Numerical computation of rectangular bivariate and trivariate normal and t probabilities", *Statistics and Computing*, 14:251-260.
+  namespace gauss_legendre {
+    const int n_half = 10;
+    const double x[n_half] = {
+      -0.9931285991850949, -0.9639719272779138, -0.9122344282513259,
+      -0.8391169718222188, -0.7463319064601508, -0.6360536807265150,
+      -0.5108670019508271, -0.3737060887154196, -0.2277858511416451,
+      -0.07652652113349733
+    };
+    const double w[n_half] = {
+      0.01761400713915212, 0.04060142980038694, 0.06267204833410906,
+      0.08327674157670475, 0.1019301198172404, 0.1181945319615184,
+      0.1316886384491766, 0.1420961093183821, 0.1491729864726037,
+      0.1527533871307259
+    };
+  } // end namespace gauss_legendre
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_QUADRATURE_HPP
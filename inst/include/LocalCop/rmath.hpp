@@ -0,0 +1,77 @@
+/// @file rmath.hpp
+///
+/// @brief Scalar subset of the **TMB** API used by the copula family headers, implemented for `Type = double` with R's math library, or without R.
+///
+/// The family headers (`gaussian.hpp`, `student.hpp`, etc.) are written against **TMB**, which provides `qnorm()`, `pbeta()`, `logspace_add()`, the `VECTORIZE` macros, etc.  When the headers are compiled outside of **TMB** (i.e., with `LOCALCOP_NO_TMB` defined), this file supplies the same functions for scalar doubles, such that the family templates can be instantiated with `double` or `LocalCop::Jet`.  The `VECTORIZE` macros expand to nothing, since vectorization is done explicitly by the caller.
+///
+/// If `LOCALCOP_STANDALONE` is defined, R's math library is replaced by the implementation in `stdmath.hpp`, such that the headers only depend on **Eigen** and the C++ standard library.
+
+#ifndef LOCALCOP_RMATH_HPP
+#define LOCALCOP_RMATH_HPP
+
+#ifdef LOCALCOP_STANDALONE
+#include "stdmath.hpp"
+#else
+#include <Rcpp.h>
+#endif
+#include <cmath>
+
+#define VECTORIZE2_tt(name)
+#define VECTORIZE4_ttti(name)
+#define VECTORIZE5_tttti(name)
+
+namespace CppAD {
+
+  /// Conditional expressions, i.e., `(left < right) ? if_true : if_false`.
+  template <class Type>
+  Type CondExpLt(const Type& left, const Type& right,
+                 const Type& if_true, const Type& if_false) {
+    return (left < right) ? if_true : if_false;
+  }
+
+  template <class Type>
+  Type CondExpGe(const Type& left, const Type& right,
+                 const Type& if_true, const Type& if_false) {
+    return (left >= right) ? if_true : if_false;
+  }
+
+} // end namespace CppAD
+
+/// Value of a scalar, i.e., the identity for doubles.
+inline double asDouble(double x) {
+  return x;
+}
+
+/// Standard normal quantile function.
+inline double qnorm(double p) {
+  return R::qnorm(p, 0.0, 1.0, 1, 0);
+}
+
+/// Standard normal CDF.
+inline double pnorm(double q) {
+  return R::pnorm(q, 0.0, 1.0, 1, 0);
+}
+
+/// Student-t density.
+inline double dt(double x, double df, int give_log) {
+  return R::dt(x, df, give_log);
+}
+
+/// Beta CDF.
+inline double pbeta(double q, double shape1, double shape2) {
+  return R::pbeta(q, shape1, shape2, 1, 0);
+}
+
+/// Beta quantile function.
+inline double qbeta(double p, double shape1, double shape2) {
+  return R::qbeta(p, shape1, shape2, 1, 0);
+}
+
+/// Calculate `log(exp(logx) + exp(logy))` without overflow.
+inline double logspace_add(double logx, double logy) {
+  return (logx > logy) ?
+    logx + std::log1p(std::exp(logy - logx)) :
+    logy + std::log1p(std::exp(logx - logy));
+}
+
+#endif // LOCALCOP_RMATH_HPP
@@ -0,0 +1,68 @@
+/// @file rng.hpp
+///
+/// @brief Random number streams for parallel simulation.
+///
+/// Simulations which are split across threads draw from one stream per block of output rather than per thread, such that the result only depends on the seed and not on the number of threads or the order in which the blocks are run.
+
+#ifndef LOCALCOP_RNG_HPP
+#define LOCALCOP_RNG_HPP
+
+#include <cstdint>
+
+namespace LocalCop {
+
+  /// Stream of uniform random numbers.
+  ///
+  /// The generator is xoshiro256** of Blackman and Vigna (2021), "Scrambled linear pseudorandom number generators", *ACM Transactions on Mathematical Software*, 47:1-32, which has period `2^256 - 1`.  The state of each stream is initialized by SplitMix64 from a hash of the seed and the stream number, such that different streams start at unrelated points of the period.
+  class RngStream {
+  private:
+    uint64_t s_[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+      return (x << k) | (x >> (64 - k));
+    }
+
+    // SplitMix64 step
+    static uint64_t splitmix64(uint64_t& x) {
+      uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+  public:
+    /// Constructor.
+    ///
+    /// @param[in] seed Seed shared by all streams.
+    /// @param[in] stream Stream number.
+    RngStream(uint64_t seed, uint64_t stream) {
+      uint64_t x = seed;
+      uint64_t h = splitmix64(x);
+      x = h ^ (stream * 0xd1b54a32d192ed03ULL);
+      h = splitmix64(x);
+      x = h;
+      for(int ii=0; ii<4; ii++) s_[ii] = splitmix64(x);
+    }
+
+    /// Next 64 random bits.
+    uint64_t next() {
+      uint64_t ans = rotl(s_[1] * 5, 7) * 9;
+      uint64_t t = s_[1] << 17;
+      s_[2] ^= s_[0];
+      s_[3] ^= s_[1];
+      s_[1] ^= s_[2];
+      s_[0] ^= s_[3];
+      s_[2] ^= t;
+      s_[3] = rotl(s_[3], 45);
+      return ans;
+    }
+
+    /// Uniform random number on the open interval `(0, 1)`.
+    double unif() {
+      return ((next() >> 11) + 0.5) * (1.0 / 9007199254740992.0); // 2^-53
+    }
+  };
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_RNG_HPP
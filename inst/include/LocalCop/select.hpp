@@ -0,0 +1,187 @@
+/// @file select.hpp
+///
+/// @brief Cross-validated likelihood and bandwidth/family selection.
+///
+/// Same calculations as `CondiCopLikCV()` and `CondiCopSelect()` with `engine = "native"`: the leave-one-out estimates of `eta` at `x[xind]` are interpolated linearly to all observations, and the cross-validated likelihood is the sum of the copula log-densities at the interpolated values, over either the observations in `xind` or all of them.
+
+#ifndef LOCALCOP_SELECT_HPP
+#define LOCALCOP_SELECT_HPP
+
+#include "fitgrid.hpp"
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace LocalCop {
+
+  /// Indices of `nx` equally spaced observations in a dataset of size `n`.
+  ///
+  /// @param[in] n Number of observations.
+  /// @param[in] nx Number of indices.
+  ///
+  /// @return Sorted (0-based) indices, i.e., `unique(round(seq(1, n, len = nx))) - 1`.
+  inline std::vector<int> cv_index(int n, int nx) {
+    std::vector<int> xind;
+    if(n <= 0 || nx <= 0) return xind;
+    if(nx == 1) return std::vector<int>(1, 0);
+    for(int ii=0; ii<nx; ii++) {
+      double xi = 1.0 + (n - 1.0) * ii / (nx - 1.0);
+      int ix = static_cast<int>(std::nearbyint(xi)) - 1;
+      if(xind.empty() || ix != xind.back()) xind.push_back(ix);
+    }
+    return xind;
+  }
+
+  /// Default bandwidths for `CondiCopSelect()`.
+  ///
+  /// @param[in] x Sorted vector of covariates.
+  /// @param[in] nband Number of bandwidths.
+  ///
+  /// @param[in] band_type Bandwidth type.
+  ///
+  /// @return `nband` bandwidths, log-equally spaced between the largest gap in `x` and its range, excluding the two smallest.  For variable bandwidths, these are divided by the range of `x` to give fractions of observations.  See `.get_band()` in `R/utils.R`.
+  inline std::vector<double> default_band(cRefVector_t<double>& x, int nband,
+                                          BandType band_type = BandType::Constant) {
+    int n = x.size();
+    double hmin = 0.0;
+    for(int ii=1; ii<n; ii++) hmin = std::max(hmin, x(ii) - x(ii-1));
+    double hmax = x(n-1) - x(0);
+    std::vector<double> band(nband);
+    for(int ii=0; ii<nband; ii++) {
+      double lb = std::log(hmin) +
+        (std::log(hmax) - std::log(hmin)) * (ii + 2.0) / (nband + 1.0);
+      band[ii] = std::exp(lb);
+      if(band_type == BandType::Variable) band[ii] = std::min(band[ii] / hmax, 1.0);
+      band[ii] = std::nearbyint(band[ii] * 1e5) / 1e5;
+    }
+    return band;
+  }
+
+  /// Control parameters of `cv_loglik()`, in addition to those of `fit_grid()`.
+  struct CVControl : public GridControl {
+    /// Whether to calculate the cross-validated likelihood at every observation, or only at those in `xind`.
+    bool cv_all = false;
+  };
+
+  /// Cross-validated likelihood.
+  ///
+  /// @param[in] utrans Matrix of marginal transformations of the uniform responses, sorted by `x`.
+  /// @param[in] x Sorted vector of covariates.
+  /// @param[in] xind Sorted (0-based) indices of the observations at which to calculate the leave-one-out estimates.
+  /// @param[in] family Copula family.
+  /// @param[in] nu Second copula parameter.
+  /// @param[in] degree Degree of the local polynomial: 0 or 1.
+  /// @param[in] kernel Kernel function.
+  /// @param[in] band Kernel bandwidth, or fraction of observations if `ctrl.band_type` is `BandType::Variable`.
+  /// @param[in] eta Starting value of `beta` for every leave-one-out fit.
+  /// @param[in] ctrl Control parameters.
+  /// @param[out] cveta Leave-one-out estimates of `eta` interpolated linearly to every element of `x`.  As with `approx()` with `rule = 1` in `CondiCopLikCV()`, these are `NaN` outside the range of `x[xind]`.
+  ///
+  /// @return The cross-validated log-likelihood, which is `NaN` if `ctrl.cv_all` is true and `x[xind]` does not span the range of `x`.
+  inline double cv_loglik(cRefMatrix_t<double>& utrans,
+                          cRefVector_t<double>& x,
+                          const std::vector<int>& xind,
+                          int family, double nu, int degree,
+                          Kernel kernel, double band,
+                          const Vector2d& eta, const CVControl& ctrl,
+                          std::vector<double>& cveta) {
+    int n = x.size();
+    int nx = xind.size();
+    // estimation step
+    VectorXd x0(nx);
+    for(int ii=0; ii<nx; ii++) x0(ii) = x(xind[ii]);
+    GridFit fit;
+    fit_grid(utrans, x, x0, xind, family, nu, degree, kernel, band,
+             eta, ctrl, fit);
+    // linear interpolation to all of x, averaging ties as in approx(),
+    // and NaN outside the range of x0 as with rule = 1
+    std::vector<double> xs, ys;
+    for(int ii=0; ii<nx; ii++) {
+      int nt = 1;
+      double y = fit.coef(0,ii);
+      while(ii+1 < nx && x0(ii+1) == x0(ii)) {
+        y += fit.coef(0,++ii);
+        nt++;
+      }
+      xs.push_back(x0(ii));
+      ys.push_back(y/nt);
+    }
+    cveta.resize(n);
+    int nu_x = xs.size();
+    for(int ii=0, jj=0; ii<n; ii++) {
+      double xi = x(ii);
+      while(jj+1 < nu_x && xs[jj+1] <= xi) jj++;
+      if(xi < xs[0] || xi > xs[nu_x-1]) {
+        cveta[ii] = std::numeric_limits<double>::quiet_NaN();
+      } else if(jj+1 >= nu_x) {
+        cveta[ii] = ys[nu_x-1];
+      } else {
+        double w = (xi - xs[jj]) / (xs[jj+1] - xs[jj]);
+        cveta[ii] = (1.0 - w) * ys[jj] + w * ys[jj+1];
+      }
+    }
+    // validation step
+    int nv = ctrl.cv_all ? n : nx;
+    int nt = utrans_size(family);
+    double v[4];
+    double cvll = 0.0;
+    for(int kk=0; kk<nv; kk++) {
+      int ii = ctrl.cv_all ? kk : xind[kk];
+      for(int jj=0; jj<nt; jj++) v[jj] = utrans(ii,jj);
+      cvll += lpdf_eta_utrans<double>(v, cveta[ii], nu, family);
+    }
+    return cvll;
+  }
+
+  /// One combination of family and bandwidth in `cv_select()`.
+  struct CVSelect {
+    int family; ///< Copula family.
+    double nu; ///< Second copula parameter.
+    double band; ///< Kernel bandwidth.
+    double cv; ///< Cross-validated log-likelihood.
+  };
+
+  /// Bandwidth and family selection by cross-validated likelihood.
+  ///
+  /// @param[in] u1 Vector of first uniform variables, sorted by `x`.
+  /// @param[in] u2 Vector of second uniform variables, sorted by `x`.
+  /// @param[in] x Sorted vector of covariates.
+  /// @param[in] xind Sorted (0-based) indices of the leave-one-out observations.
+  /// @param[in] family Copula families.
+  /// @param[in] nu Second copula parameter of each family.
+  /// @param[in] band Kernel bandwidths.
+  /// @param[in] degree Degree of the local polynomial: 0 or 1.
+  /// @param[in] kernel Kernel function.
+  /// @param[in] eta Starting value of `beta` for every leave-one-out fit.
+  /// @param[in] ctrl Control parameters.
+  ///
+  /// @return The cross-validated log-likelihood at every combination of family and bandwidth, with the bandwidths varying fastest as in `CondiCopSelect()`.  The selected combination is the one with the largest `cv`.
+  inline std::vector<CVSelect> cv_select(cRefVector_t<double>& u1,
+                                         cRefVector_t<double>& u2,
+                                         cRefVector_t<double>& x,
+                                         const std::vector<int>& xind,
+                                         const std::vector<int>& family,
+                                         const std::vector<double>& nu,
+                                         const std::vector<double>& band,
+                                         int degree, Kernel kernel,
+                                         const Vector2d& eta,
+                                         const CVControl& ctrl) {
+    std::vector<CVSelect> out;
+    std::vector<double> cveta;
+    for(std::size_t ifam=0; ifam<family.size(); ifam++) {
+      // marginal transformations, shared by all bandwidths
+      MatrixXd ut(x.size(), utrans_size(family[ifam]));
+      utrans(u1, u2, nu[ifam], family[ifam], ut);
+      for(std::size_t ib=0; ib<band.size(); ib++) {
+        double cv = cv_loglik(ut, x, xind, family[ifam], nu[ifam], degree,
+                              kernel, band[ib], eta, ctrl, cveta);
+        out.push_back({family[ifam], nu[ifam], band[ib], cv});
+      }
+    }
+    return out;
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_SELECT_HPP
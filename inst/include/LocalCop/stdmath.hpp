@@ -0,0 +1,367 @@
+/// @file stdmath.hpp
+///
+/// @brief Subset of R's math library (`Rmath.h`) implemented with the C++ standard library.
+///
+/// When the headers are compiled without R (i.e., with `LOCALCOP_STANDALONE` defined), `rmath.hpp` and `jet.hpp` call the functions in namespace `R` below instead of those provided by **Rcpp**.  They have the same signatures and conventions as their R counterparts, except that the quantile functions don't accept `log_p = true`, and that non-finite arguments are handled only as far as needed by the copula families.
+///
+/// The normal distribution functions are based on `std::erfc()`, the Student-t and beta distribution functions on the continued fraction for the regularized incomplete beta function, and the quantile functions are refined by Newton steps from closed-form approximations.  Against reference implementations, the relative error of the normal CDF and quantile function is below `1e-15`, and that of the Student-t CDF and quantile function is below `1e-13` for `0.5 <= df <= 100` and below `5e-13` for `df <= 1e3`.  The relative error of the latter grows proportionally to `df` beyond this, since it is dominated by the rounding error of `(df/2) * log(x)` in the incomplete beta function.
+
+#ifndef LOCALCOP_STDMATH_HPP
+#define LOCALCOP_STDMATH_HPP
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace R {
+
+  namespace stdmath {
+
+    const double LN_SQRT_2PI = 0.918938533204672741780329736406;
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    /// Convert a probability to the lower tail and/or log scale.
+    inline double p_out(double p, double q, int lower_tail, int log_p) {
+      double ans = lower_tail ? p : q;
+      return log_p ? std::log(ans) : ans;
+    }
+
+    /// Remainder of Stirling's formula, `lgamma(z) - (z-1/2) log(z) + z - log(sqrt(2 pi))`, for `z >= 20`.
+    inline double stirling_corr(double z) {
+      double z2 = 1.0/(z*z);
+      return (1.0/12.0 - z2 * (1.0/360.0 - z2 * (1.0/1260.0 - z2/1680.0)))/z;
+    }
+
+    /// Logarithm of the beta function.
+    ///
+    /// For large arguments, the difference `lgamma(a) - lgamma(a+b)` is calculated with Stirling's formula to avoid cancellation.
+    inline double lbeta(double a, double b) {
+      double p = std::min(a, b);
+      double q = std::max(a, b);
+      if(q < 20.0) {
+        return std::lgamma(a) + std::lgamma(b) - std::lgamma(a + b);
+      }
+      // lgamma(q) - lgamma(p+q) without cancellation
+      double dq = -(q - 0.5) * std::log1p(p/q) - p * std::log(p + q) + p +
+        stirling_corr(q) - stirling_corr(p + q);
+      return std::lgamma(p) + dq;
+    }
+
+    /// Continued fraction for the regularized incomplete beta function, with modified Lentz's method.
+    ///
+    /// Converges rapidly for `x < (a+1)/(a+b+2)`.
+    inline double betacf(double x, double a, double b) {
+      const int maxit = 10000;
+      const double eps = 1e-16;
+      const double tiny = 1e-300;
+      double qab = a + b;
+      double qap = a + 1.0;
+      double qam = a - 1.0;
+      double c = 1.0;
+      double d = 1.0 - qab * x / qap;
+      if(std::abs(d) < tiny) d = tiny;
+      d = 1.0/d;
+      double h = d;
+      for(int m=1; m<=maxit; m++) {
+        int m2 = 2*m;
+        double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+        d = 1.0 + aa * d;
+        if(std::abs(d) < tiny) d = tiny;
+        c = 1.0 + aa / c;
+        if(std::abs(c) < tiny) c = tiny;
+        d = 1.0/d;
+        h *= d * c;
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+        d = 1.0 + aa * d;
+        if(std::abs(d) < tiny) d = tiny;
+        c = 1.0 + aa / c;
+        if(std::abs(c) < tiny) c = tiny;
+        d = 1.0/d;
+        double del = d * c;
+        h *= del;
+        if(std::abs(del - 1.0) < eps) break;
+      }
+      return h;
+    }
+
+    /// Regularized incomplete beta function and its complement.
+    ///
+    /// @param[in] x Argument in `[0,1]`.
+    /// @param[in] y Complement `1-x`, which is passed separately such that it can be calculated without cancellation.
+    /// @param[in] a First shape parameter.
+    /// @param[in] b Second shape parameter.
+    /// @param[out] q The complement `1 - I_x(a,b)`.
+    ///
+    /// @return The value of `I_x(a,b)`.
+    inline double ibeta(double x, double y, double a, double b, double& q) {
+      if(x <= 0.0) {
+        q = 1.0;
+        return 0.0;
+      }
+      if(y <= 0.0) {
+        q = 0.0;
+        return 1.0;
+      }
+      double lbt = a * std::log(x) + b * std::log(y) - lbeta(a, b);
+      if(x < (a + 1.0)/(a + b + 2.0)) {
+        double p = std::exp(lbt) * betacf(x, a, b) / a;
+        q = 1.0 - p;
+        return p;
+      } else {
+        q = std::exp(lbt) * betacf(y, b, a) / b;
+        return 1.0 - q;
+      }
+    }
+
+    /// Solve `I_x(a,b) = p` for `p <= 1/2` by Newton's method on the log scale, safeguarded by bisection.
+    ///
+    /// @param[in] p Lower tail probability.
+    /// @param[in] a,b Shape parameters.
+    /// @param[out] y The complement `1-x`.
+    ///
+    /// @return The solution `x`.
+    inline double qbeta_lower(double p, double a, double b, double& y) {
+      const int maxit = 200;
+      double lp = std::log(p);
+      double lb = lbeta(a, b);
+      // tail approximation I_x(a,b) ~ x^a / (a B(a,b))
+      double x = std::exp((lp + std::log(a) + lb)/a);
+      if(!(x < 1.0)) x = 0.5;
+      double lo = 0.0, hi = 1.0;
+      for(int it=0; it<maxit; it++) {
+        double q;
+        double px = ibeta(x, 1.0 - x, a, b, q);
+        if(px < p) lo = x; else hi = x;
+        // derivative of log I_x with respect to log x
+        double ldens = a * std::log(x) + (b - 1.0) * std::log1p(-x) - lb;
+        double step = (std::log(px) - lp) / (std::exp(ldens) / px);
+        double xnew = x * std::exp(-step);
+        if(std::abs(xnew - x) <= 1e-15 * x) {
+          x = xnew;
+          break;
+        }
+        if(!(xnew > lo && xnew < hi)) {
+          // bisection, on the log scale for small x
+          xnew = (lo > 0.0 && hi > 4.0 * lo) ?
+            std::sqrt(lo * hi) : 0.5 * (lo + hi);
+        }
+        x = xnew;
+      }
+      y = 1.0 - x;
+      return x;
+    }
+
+    /// Standard normal CDF.
+    ///
+    /// Since `erfc(t)` has relative condition number `2t^2` for large `t`, the rounding error of `t = -z / sqrt(2)` is corrected to first order.
+    inline double Phi(double z) {
+      const double SQRT1_2_LO = -4.8336466567264567e-17; // sqrt(1/2) - M_SQRT1_2
+      double t = -z * M_SQRT1_2;
+      double dt = std::fma(-z, M_SQRT1_2, -t) - z * SQRT1_2_LO;
+      return 0.5 * (std::erfc(t) - dt * M_2_SQRTPI * std::exp(-t * t));
+    }
+
+  } // end namespace stdmath
+
+  /// Normal density.
+  inline double dnorm(double x, double mu, double sigma, int give_log) {
+    double z = (x - mu)/sigma;
+    double ld = -(stdmath::LN_SQRT_2PI + 0.5 * z * z + std::log(sigma));
+    return give_log ? ld : std::exp(ld);
+  }
+
+  /// Normal CDF.
+  inline double pnorm(double q, double mu, double sigma,
+                      int lower_tail, int log_p) {
+    double z = (q - mu)/sigma;
+    if(std::isnan(z)) return z;
+    double p = stdmath::Phi(z);
+    double pc = stdmath::Phi(-z);
+    return stdmath::p_out(p, pc, lower_tail, log_p);
+  }
+
+  /// Normal quantile function.
+  ///
+  /// Acklam's rational approximation, refined by a Halley step.
+  inline double qnorm(double p, double mu, double sigma,
+                      int lower_tail, int log_p) {
+    static const double a[6] = {
+      -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+      1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00
+    };
+    static const double b[5] = {
+      -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+      6.680131188771972e+01, -1.328068155288572e+01
+    };
+    static const double c[6] = {
+      -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+      -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00
+    };
+    static const double d[4] = {
+      7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+      3.754408661907416e+00
+    };
+    if(log_p) p = std::exp(p);
+    if(!lower_tail) p = 1.0 - p;
+    if(std::isnan(p) || p < 0.0 || p > 1.0) return stdmath::NaN;
+    if(p == 0.0) return -std::numeric_limits<double>::infinity();
+    if(p == 1.0) return std::numeric_limits<double>::infinity();
+    // work with the lower tail
+    double pl = std::min(p, 1.0 - p);
+    double z;
+    if(pl < 0.02425) {
+      double t = std::sqrt(-2.0 * std::log(pl));
+      z = (((((c[0]*t + c[1])*t + c[2])*t + c[3])*t + c[4])*t + c[5]) /
+        ((((d[0]*t + d[1])*t + d[2])*t + d[3])*t + 1.0);
+    } else {
+      double t = pl - 0.5;
+      double r = t * t;
+      z = (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*t /
+        (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+    }
+    // Halley step, with the lower tail probability relative to pl
+    double e = stdmath::Phi(z) - pl;
+    double u = e * std::exp(stdmath::LN_SQRT_2PI + 0.5 * z * z);
+    z -= u/(1.0 + 0.5 * z * u);
+    if(p > 0.5) z = -z;
+    return mu + sigma * z;
+  }
+
+  /// Student-t density.
+  inline double dt(double x, double df, int give_log) {
+    if(std::isinf(df)) return dnorm(x, 0.0, 1.0, give_log);
+    double ld = -stdmath::lbeta(0.5 * df, 0.5) - 0.5 * std::log(df) -
+      0.5 * (df + 1.0) * std::log1p(x * x / df);
+    return give_log ? ld : std::exp(ld);
+  }
+
+  /// Student-t CDF.
+  inline double pt(double q, double df, int lower_tail, int log_p) {
+    if(std::isnan(q) || std::isnan(df)) return q + df;
+    if(std::isinf(df)) return pnorm(q, 0.0, 1.0, lower_tail, log_p);
+    double tail, mid;
+    if(std::isinf(q)) {
+      tail = 0.0;
+    } else {
+      // P(|T| > |q|) = I_x(df/2, 1/2) with x = df / (df + q^2)
+      double q2 = q * q;
+      tail = stdmath::ibeta(df/(df + q2), q2/(df + q2),
+                            0.5 * df, 0.5, mid);
+    }
+    double p = 0.5 * tail;
+    return (q > 0.0) ?
+      stdmath::p_out(1.0 - p, p, lower_tail, log_p) :
+      stdmath::p_out(p, 1.0 - p, lower_tail, log_p);
+  }
+
+  /// Student-t quantile function.
+  ///
+  /// Inverts the incomplete beta function for whichever of `I_x(df/2, 1/2)` and its complement is smaller, then refines the result with Newton steps on `pt()`.
+  inline double qt(double p, double df, int lower_tail, int log_p) {
+    if(log_p) p = std::exp(p);
+    if(!lower_tail) p = 1.0 - p;
+    if(std::isnan(p) || std::isnan(df) || p < 0.0 || p > 1.0 || df <= 0.0) {
+      return stdmath::NaN;
+    }
+    if(p == 0.0) return -std::numeric_limits<double>::infinity();
+    if(p == 1.0) return std::numeric_limits<double>::infinity();
+    if(p == 0.5) return 0.0;
+    if(std::isinf(df)) return qnorm(p, 0.0, 1.0, 1, 0);
+    double pl = std::min(p, 1.0 - p);
+    double x, y, q;
+    if(2.0 * pl < 0.5) {
+      // 2 pl = I_x(df/2, 1/2) ~ x^(df/2) / (df/2 B(df/2, 1/2)) as x -> 0
+      double lx = (std::log(2.0 * pl) + std::log(0.5 * df) +
+                   stdmath::lbeta(0.5 * df, 0.5))/(0.5 * df);
+      if(lx < -600.0) {
+        // x underflows, but the tail approximation is exact to double precision
+        q = -std::sqrt(df) * std::exp(-0.5 * lx);
+        return (p > 0.5) ? -q : q;
+      }
+      x = stdmath::qbeta_lower(2.0 * pl, 0.5 * df, 0.5, y);
+    } else {
+      // 1 - 2 pl = I_y(1/2, df/2)
+      y = stdmath::qbeta_lower(1.0 - 2.0 * pl, 0.5, 0.5 * df, x);
+    }
+    q = -std::sqrt(df * y / x);
+    // Newton refinement on the lower tail
+    for(int it=0; it<2; it++) {
+      double dens = dt(q, df, 0);
+      if(!(dens > 0.0)) break;
+      q -= (pt(q, df, 1, 0) - pl)/dens;
+    }
+    return (p > 0.5) ? -q : q;
+  }
+
+  /// Beta CDF.
+  inline double pbeta(double q, double shape1, double shape2,
+                      int lower_tail, int log_p) {
+    if(std::isnan(q) || std::isnan(shape1) || std::isnan(shape2)) {
+      return q + shape1 + shape2;
+    }
+    double pc;
+    double p = stdmath::ibeta(std::max(q, 0.0), 1.0 - std::min(q, 1.0),
+                              shape1, shape2, pc);
+    return stdmath::p_out(p, pc, lower_tail, log_p);
+  }
+
+  /// Beta quantile function.
+  inline double qbeta(double p, double shape1, double shape2,
+                      int lower_tail, int log_p) {
+    if(log_p) p = std::exp(p);
+    if(!lower_tail) p = 1.0 - p;
+    if(std::isnan(p) || p < 0.0 || p > 1.0) return stdmath::NaN;
+    if(p == 0.0) return 0.0;
+    if(p == 1.0) return 1.0;
+    double x, y;
+    if(p <= 0.5) {
+      x = stdmath::qbeta_lower(p, shape1, shape2, y);
+    } else {
+      y = stdmath::qbeta_lower(1.0 - p, shape2, shape1, x);
+    }
+    return x;
+  }
+
+  /// Digamma function.
+  ///
+  /// Uses the recurrence `psi(x) = psi(x+1) - 1/x` up to `x >= 12`, followed by the asymptotic expansion.  Negative arguments use the reflection formula.
+  inline double digamma(double x) {
+    if(x <= 0.0 && x == std::floor(x)) return stdmath::NaN;
+    if(x < 0.0) {
+      return digamma(1.0 - x) - M_PI / std::tan(M_PI * x);
+    }
+    double ans = 0.0;
+    while(x < 12.0) {
+      ans -= 1.0/x;
+      x += 1.0;
+    }
+    double x2 = 1.0/(x*x);
+    ans += std::log(x) - 0.5/x -
+      x2 * (1.0/12.0 - x2 * (1.0/120.0 - x2 * (1.0/252.0 - x2 * (1.0/240.0 - x2/132.0))));
+    return ans;
+  }
+
+  /// Trigamma function.
+  ///
+  /// Computed in the same way as `digamma()`.
+  inline double trigamma(double x) {
+    if(x <= 0.0 && x == std::floor(x)) return stdmath::NaN;
+    if(x < 0.0) {
+      double s = std::sin(M_PI * x);
+      return -trigamma(1.0 - x) + M_PI * M_PI / (s * s);
+    }
+    double ans = 0.0;
+    while(x < 12.0) {
+      ans += 1.0/(x*x);
+      x += 1.0;
+    }
+    double ix = 1.0/x;
+    double x2 = ix * ix;
+    ans += ix + 0.5 * x2 +
+      ix * x2 * (1.0/6.0 - x2 * (1.0/30.0 - x2 * (1.0/42.0 - x2 * (1.0/30.0 - x2 * 5.0/66.0))));
+    return ans;
+  }
+
+} // end namespace R
+
+#endif // LOCALCOP_STDMATH_HPP
@@ -5,6 +5,8 @@
 
 // this is where RefVector_t etc. is defined
 #include "config.hpp"
+#include "tdist.hpp"
+#include "quadrature.hpp"
 
 #ifndef M_LN_SQRT_2PI
 #define M_LN_SQRT_2PI	0.918938533204672741780329736406	/* log(sqrt(2*pi))
@@ -13,42 +15,138 @@
 
 namespace LocalCop {
 
+  /// Student-t CDF in terms of the incomplete beta function.
+  template <class Type>
+  Type pt_beta(Type q, Type df) {
+    Type res = Type(0.5) * pbeta(df/(q*q + df), Type(0.5) * df, Type(0.5));
+    return CppAD::CondExpLt(q, Type(0.0), res, Type(1.0) - res); 
+  }
+
+  /// Student-t quantile function in terms of the inverse incomplete beta function.
+  template <class Type>
+  Type qt_beta(Type p, Type df) {
+    Type p2 = CppAD::CondExpGe(p, Type(0.5), p, Type(1.0) - p);
+    Type res = qbeta(Type(2.0)  * (Type(1.0) - p2), Type(0.5) * df, Type(0.5));
+    res = sqrt(df/res - df);
+    return CppAD::CondExpGe(p, Type(0.5), res, -res);
+  }
+
   /// Distribution function of the Student-t distribution.
   ///
-  /// This implementation is defined in terms of the incomplete beta function: <https://en.wikipedia.org/wiki/Student%27s_t-distribution#Cumulative_distribution_function>.
+  /// This implementation is defined in terms of the incomplete beta function: <https://en.wikipedia.org/wiki/Student%27s_t-distribution#Cumulative_distribution_function>.  If `df` is a constant integer no larger than `PT_INT_MAX`, the closed form `pt_int()` is used instead, which is considerably cheaper to evaluate and differentiate.
   ///
   /// @param[in] q Quantile.
   /// @param[in] df Degrees of freedom.
   ///
   /// @return Value of the CDF at `q`.
-  ///
-  /// @todo Make this function identical to its R implementation, which handles a few edge cases differently.
   template <class Type>
   Type pt(Type q, Type df) {
-    Type res = Type(0.5) * pbeta(df/(q*q + df), Type(0.5) * df, Type(0.5));
-    return CppAD::CondExpLt(q, Type(0.0), res, Type(1.0) - res); 
+    if(is_constant(df) && is_int_df(asDouble(df))) {
+      return pt_int(q, static_cast<int>(asDouble(df)));
+    }
+    return pt_beta(q, df);
   }
   VECTORIZE2_tt(pt)
 
+  /// Distribution function of the Student-t distribution.
+  ///
+  /// Uses `pt_int()` for integer `df` no larger than `PT_INT_MAX`.  Otherwise, uses R's `pt()` when compiled outside of **TMB**, such that edge cases (`df = Inf`, infinite `q`, etc.) are handled as in R, and `pt_beta()` within **TMB**.
+  ///
+  /// @param[in] q Quantile.
+  /// @param[in] df Degrees of freedom.
+  ///
+  /// @return Value of the CDF at `q`.
+  inline double pt(double q, double df) {
+    if(is_int_df(df) && std::isfinite(q)) {
+      return pt_int(q, static_cast<int>(df));
+    }
+#ifdef LOCALCOP_NO_TMB
+    return R::pt(q, df, 1, 0);
+#else
+    return pt_beta(q, df);
+#endif
+  }
+
   /// Quantile function of the Student-t distribution. 
   ///
-  /// Defined via direct inversion of `pt()`.
+  /// If `p` and `df` are both constants, the quantile is calculated by `qt(double, double)` when the AD tape is built.  Otherwise, if `df` is a constant equal to 1, 2, or 4, the closed form `qt_int()` is used.  In all other cases the quantile is defined via direct inversion of `pt()`, i.e., by `qt_beta()`.  When `df` is a parameter and the quantile is required at many values of `df` for the same `p`, `qt_newton()` from a quantile cached at the previous value of `df` gives the same value and derivatives at a fraction of the cost.
   /// 
   /// @param[in] p Probability.
   /// @param[in] df Degrees of freedom.
   ///
   /// @return Quantile of the Student-t corresponding to `p`.
+  template <class Type>
+  Type qt(Type p, Type df);
+
+  /// Quantile function of the Student-t distribution.
+  ///
+  /// Uses `qt_int()` for `df = 1, 2, 4`.  Otherwise, uses R's `qt()` when compiled outside of **TMB**, and `qt_beta()` within **TMB**.  The former is Hill's (1970) approximation refined by Taylor expansion steps, which is much faster than inverting `pbeta()`, and makes the marginal transformations of the Student-t copula identical to those calculated in R.
+  ///
+  /// @param[in] p Probability.
+  /// @param[in] df Degrees of freedom.
   ///
-  /// @todo Make this function identical to its R implementation.
+  /// @return Quantile of the Student-t corresponding to `p`.
+  inline double qt(double p, double df) {
+    if((df == 1.0 || df == 2.0 || df == 4.0) && p > 0.0 && p < 1.0) {
+      return qt_int(p, static_cast<int>(df));
+    }
+#ifdef LOCALCOP_NO_TMB
+    return R::qt(p, df, 1, 0);
+#else
+    return qt_beta(p, df);
+#endif
+  }
+
   template <class Type>
   Type qt(Type p, Type df) {
-    Type p2 = CppAD::CondExpGe(p, Type(0.5), p, Type(1.0) - p);
-    Type res = qbeta(Type(2.0)  * (Type(1.0) - p2), Type(0.5) * df, Type(0.5));
-    res = sqrt(df/res - df);
-    return CppAD::CondExpGe(p, Type(0.5), res, -res);
+    if(is_constant(df)) {
+      double nu = asDouble(df);
+      if(is_constant(p)) return Type(qt(asDouble(p), nu));
+      if(nu == 1.0 || nu == 2.0 || nu == 4.0) {
+        return qt_int(p, static_cast<int>(nu));
+      }
+    }
+    return qt_beta(p, df);
   }
   VECTORIZE2_tt(qt)
 
+  /// Student-t quantile refined from a cached value.
+  ///
+  /// Takes one Newton step for the root of `pt(y, df) = p`, starting from `y0`.  When `y0 = qt(p, df0)` was calculated at the current value `df0` of `df` (e.g., in R), the result equals `y0`, and its derivative with respect to `df` is the exact derivative of `qt(p, df)`, i.e., `-dpt/ddf / dt(y0, df)`.  This avoids differentiating through the inversion of `pbeta()` in `qt()`.  When `df` has moved away from `df0`, the result is still a second-order accurate approximation of `qt(p, df)`.
+  ///
+  /// @param[in] p Probability.
+  /// @param[in] y0 Cached quantile, i.e., `qt(p, df0)`.
+  /// @param[in] df Degrees of freedom.
+  ///
+  /// @return Refined quantile of the Student-t corresponding to `p`.
+  template <class Type>
+  Type qt_newton(Type p, Type y0, Type df) {
+    return y0 - (pt(y0, df) - p) / dt(y0, df, 0);
+  }
+
+  /// Calculate Student-t copula PDF in terms of Student-t quantiles.
+  ///
+  /// @param[in] y1 First Student-t quantile, i.e., `qt(u1, nu)`.
+  /// @param[in] y2 Second Student-t quantile, i.e., `qt(u2, nu)`.
+  /// @param[in] lmarg Sum of the marginal log-PDFs, i.e., `dt(y1, nu, 1) + dt(y2, nu, 1)`.
+  /// @param[in] theta Correlation parameter of the Student-t copula with the range $(-1, 1)$.
+  /// @param[in] nu Degrees of freedom parameter.
+  /// @param[in] give_log Whether or not to return on the log scale.
+  ///
+  /// @return Value of the copula PDF.
+  template <class Type>
+  Type dstudent_t(Type y1, Type y2, Type lmarg, Type theta, Type nu,
+                  int give_log=0) {
+    // bivariate student log-pdf
+    Type det = 1.0 - theta*theta;
+    Type ans = (y1*y1 + y2*y2 - 2.0*theta * y1*y2) / det;
+    ans = -(.5 * nu + 1.0) * log(1.0 + ans/nu);
+    ans -= 2.0 * M_LN_SQRT_2PI + .5 * log(det);
+    // marginals
+    ans -= lmarg;
+    if(give_log) return ans; else return exp(ans);
+  }
+
   /// Calculate Student-t copula PDF.
   //
   /// @param[in] u1 First uniform variable.
@@ -63,14 +161,9 @@ namespace LocalCop {
     // student-t quantiles
     Type y1 = qt(u1, nu);
     Type y2 = qt(u2, nu);
-    // bivariate student log-pdf
-    Type det = 1.0 - theta*theta;
-    Type ans = (y1*y1 + y2*y2 - 2.0*theta * y1*y2) / det;
-    ans = -(.5 * nu + 1.0) * log(1.0 + ans/nu);
-    ans -= 2.0 * M_LN_SQRT_2PI + .5 * log(det);
     // marginals
-    ans -= dt(y1, nu, 1) + dt(y2, nu, 1);
-    if(give_log) return ans; else return exp(ans);
+    Type lmarg = dt(y1, nu, 1) + dt(y2, nu, 1);
+    return dstudent_t(y1, y2, lmarg, theta, nu, give_log);
   }
   VECTORIZE5_tttti(dstudent)
 
@@ -88,17 +181,214 @@ namespace LocalCop {
     // student-t quantiles
     Type y1 = qt(u1, nu);
     Type y2 = qt(u2, nu);
-    Type loc = theta * y2;
+    // conditional distribution of y2 given y1
+    Type loc = theta * y1;
     Type det = 1.0 - theta*theta;
     Type nu1 = nu + 1.0;
-    Type scale = sqrt((nu + y2*y2)/nu1 * det);
-    Type z = (y1 - loc)/scale;
+    Type scale = sqrt((nu + y1*y1)/nu1 * det);
+    Type z = (y2 - loc)/scale;
     Type ans = pt(z, nu1);
     if(give_log) return log(ans); else return ans;
   }
   VECTORIZE5_tttti(hstudent)
 
-  
+  /// Calculate the inverse of the Student-t copula h-function with respect to u2.
+  ///
+  /// @param[in] p Probability.
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] theta Correlation parameter of the Student-t copula with the range $(-1, 1)$.
+  /// @param[in] nu Degrees of freedom parameter.
+  ///
+  /// @return Value of `u2` such that `hstudent(u1, u2, theta, nu) = p`.
+  template <class Type>
+  Type hinvstudent(Type p, Type u1, Type theta, Type nu) {
+    Type y1 = qt(u1, nu);
+    Type nu1 = nu + 1.0;
+    Type scale = sqrt((nu + y1*y1)/nu1 * (1.0 - theta*theta));
+    Type y2 = qt(p, nu1) * scale + theta * y1;
+    return pt(y2, nu);
+  }
+
+
+  /// Bivariate Student-t CDF for integer degrees of freedom.
+  ///
+  /// Calculates `P(T1 < h, T2 < k)` for a standard bivariate Student-t distribution with correlation `r` and `nu` degrees of freedom, using the finite series of Dunnett & Sobel (1954) as implemented by Genz (2004), "Numerical computation of rectangular bivariate and trivariate normal and t probabilities", *Statistics and Computing*, 14:251-260.  The series has `floor(nu/2)` terms, each involving elementary functions only.  Genz's implementation takes the absolute values of `h - r*k` and `k - r*h` and multiplies by their signs, which is replaced here by carrying the signs through the recursions, such that the derivatives exist everywhere.
+  ///
+  /// @param[in] h First upper limit.
+  /// @param[in] k Second upper limit.
+  /// @param[in] r Correlation with the range $(-1, 1)$.
+  /// @param[in] nu Degrees of freedom.  A positive integer.
+  ///
+  /// @return Value of the CDF.
+  template <class Type>
+  Type pbvt_int(Type h, Type k, Type r, int nu) {
+    const double two_pi = 6.283185307179586;
+    Type nu_ = Type(double(nu));
+    Type ors = Type(1.0) - r * r;
+    Type hrk = h - r * k;
+    Type krh = k - r * h;
+    Type hh = h * h;
+    Type kk = k * k;
+    // signed sqrt(xnhk) and sqrt(1 - xnhk) in Genz's notation, etc.
+    Type dhk = sqrt(hrk * hrk + ors * (nu_ + kk));
+    Type dkh = sqrt(krh * krh + ors * (nu_ + hh));
+    Type shk = hrk / dhk;
+    Type chk = sqrt(ors * (nu_ + kk)) / dhk;
+    Type skh = krh / dkh;
+    Type ckh = sqrt(ors * (nu_ + hh)) / dkh;
+    Type xhk = chk * chk; // 1 - xnhk
+    Type xkh = ckh * ckh;
+    Type bvt;
+    if(nu % 2 == 0) {
+      bvt = atan2(sqrt(ors), -r) / Type(two_pi);
+      Type gmph = h / sqrt(Type(16.0) * (nu_ + hh));
+      Type gmpk = k / sqrt(Type(16.0) * (nu_ + kk));
+      Type btnckh = Type(2.0 / M_PI) * atan2(skh, ckh);
+      Type btpdkh = Type(2.0 / M_PI) * skh * ckh;
+      Type btnchk = Type(2.0 / M_PI) * atan2(shk, chk);
+      Type btpdhk = Type(2.0 / M_PI) * shk * chk;
+      for(int j=1; j<=nu/2; j++) {
+        bvt += gmph * (Type(1.0) + btnckh);
+        bvt += gmpk * (Type(1.0) + btnchk);
+        btnckh += btpdkh;
+        btpdkh = Type(2.0 * j / (2.0 * j + 1.0)) * btpdkh * xkh;
+        btnchk += btpdhk;
+        btpdhk = Type(2.0 * j / (2.0 * j + 1.0)) * btpdhk * xhk;
+        gmph = gmph * Type((2.0 * j - 1.0) / (2.0 * j)) / (Type(1.0) + hh / nu_);
+        gmpk = gmpk * Type((2.0 * j - 1.0) / (2.0 * j)) / (Type(1.0) + kk / nu_);
+      }
+    } else {
+      Type snu = sqrt(nu_);
+      Type qhrk = sqrt(hh + kk - Type(2.0) * r * h * k + nu_ * ors);
+      Type hkrn = h * k + r * nu_;
+      Type hkn = h * k - nu_;
+      Type hpk = h + k;
+      bvt = atan2(-snu * (hkn * qhrk + hpk * hkrn),
+                  hkn * hkrn - nu_ * hpk * qhrk) / Type(two_pi);
+      bvt = CppAD::CondExpLt(bvt, Type(-1e-15), bvt + Type(1.0), bvt);
+      Type gmph = h / (Type(two_pi) * snu * (Type(1.0) + hh / nu_));
+      Type gmpk = k / (Type(two_pi) * snu * (Type(1.0) + kk / nu_));
+      Type btnckh = skh;
+      Type btpdkh = skh;
+      Type btnchk = shk;
+      Type btpdhk = shk;
+      for(int j=1; j<=(nu-1)/2; j++) {
+        bvt += gmph * (Type(1.0) + btnckh);
+        bvt += gmpk * (Type(1.0) + btnchk);
+        btpdkh = Type((2.0 * j - 1.0) / (2.0 * j)) * btpdkh * xkh;
+        btnckh += btpdkh;
+        btpdhk = Type((2.0 * j - 1.0) / (2.0 * j)) * btpdhk * xhk;
+        btnchk += btpdhk;
+        gmph = gmph * Type(2.0 * j / (2.0 * j + 1.0)) / (Type(1.0) + hh / nu_);
+        gmpk = gmpk * Type(2.0 * j / (2.0 * j + 1.0)) / (Type(1.0) + kk / nu_);
+      }
+    }
+    return bvt;
+  }
+
+  /// Integrand of `pbvt_quad()`.
+  ///
+  /// Derivative of the bivariate Student-t CDF with respect to `rho = cos(psi)`, multiplied by `d rho / d psi`, i.e.,
+  ///
+  /// ```
+  /// (1 + (h^2 + k^2 - 2*h*k*cos(psi)) / (nu * sin(psi)^2))^(-nu/2) / (2*pi),
+  /// ```
+  ///
+  /// where the numerator is written as `(h-k)^2 + 4*h*k*sin(psi/2)^2` to avoid cancellation for large `h = k`.
+  ///
+  /// @param[in] psi Angle with the range $(0, \pi)$.
+  /// @param[in] a1 Equals `(h-k)^2 / nu`.
+  /// @param[in] a2 Equals `h*k / nu`.
+  /// @param[in] nu Degrees of freedom.
+  template <class Type>
+  Type pbvt_dr(Type psi, Type a1, Type a2, Type nu) {
+    Type sp = sin(psi);
+    Type cp2 = cos(psi / Type(2.0));
+    Type ans = Type(1.0) + a1 / (sp * sp) + a2 / (cp2 * cp2);
+    return exp(Type(-0.5) * nu * log(ans)) / Type(6.283185307179586);
+  }
+
+  /// Bivariate Student-t CDF by quadrature.
+  ///
+  /// Calculates `P(T1 < h, T2 < k)` for a standard bivariate Student-t distribution with correlation `r` and any degrees of freedom `nu > 0`, from the analogue of Plackett's identity for the bivariate normal: the derivative of the CDF with respect to the correlation `rho` is `(1 + (h^2 + k^2 - 2*rho*h*k) / (nu * (1-rho^2)))^(-nu/2) / (2*pi*sqrt(1-rho^2))` (e.g., Genz 2004, "Numerical computation of rectangular bivariate and trivariate normal and t probabilities", *Statistics and Computing*, 14:251-260).  This is integrated from `rho = sign(r)`, where the CDF is `min(u1, u2)` for `r >= 0` and `max(u1 + u2 - 1, 0)` for `r < 0`, with `u1 = pt(h, nu)` and `u2 = pt(k, nu)`.  Since the bivariate Student-t with `rho = 0` doesn't have independent margins, there is no such closed form at the other end.
+  ///
+  /// In terms of the angle `psi = acos(|rho|)` from the starting point, the integrand has a boundary layer of width `|h - sign(r)*k| / sqrt(nu + h^2 + k^2)` at `psi = 0`.  The integral is therefore split at `psi_r / 8`, where `psi_r = acos(|r|)`.  The first part uses the substitution `psi = psi0 * sinh(z)`, with `psi0` the width of the boundary layer, and two panels of the 20-point Gauss-Legendre rule in `z`.  The second part uses the same rule in `psi`.  Against adaptive quadrature of the same identity in extended precision, the absolute error is below `1e-13` for `3 <= nu <= 10`, and below `1e-11` for `2 <= nu <= 150`.  It grows as `nu` decreases below 2, to about `1e-10` at `nu = 1.5` and `1e-7` at `nu = 0.5`, and is largest for `u1` and `u2` near 1/2 and small `|r|`.
+  ///
+  /// @param[in] u1 First uniform variable, `pt(h, nu)`.
+  /// @param[in] u2 Second uniform variable, `pt(k, nu)`.
+  /// @param[in] h First upper limit.
+  /// @param[in] k Second upper limit.
+  /// @param[in] r Correlation with the range $(-1, 1)$.
+  /// @param[in] nu Degrees of freedom.
+  ///
+  /// @return Value of the CDF.
+  template <class Type>
+  Type pbvt_quad(Type u1, Type u2, Type h, Type k, Type r, Type nu) {
+    using namespace gauss_legendre;
+    // CDF at rho = sign(r)
+    Type sgn = CppAD::CondExpGe(r, Type(0.0), Type(1.0), Type(-1.0));
+    Type umin = CppAD::CondExpLt(u1, u2, u1, u2);
+    Type ulow = u1 + u2 - Type(1.0);
+    ulow = CppAD::CondExpLt(ulow, Type(0.0), Type(0.0), ulow);
+    Type p1 = CppAD::CondExpGe(r, Type(0.0), umin, ulow);
+    // integration range and width of the boundary layer
+    Type abs_r = sgn * r;
+    Type psi_r = Type(M_PI / 2.0) - asin(abs_r);
+    Type psi1 = psi_r / Type(8.0);
+    Type hmk = h - sgn * k;
+    Type a1 = hmk * hmk / nu;
+    Type a2 = sgn * h * k / nu;
+    hmk = CppAD::CondExpGe(hmk, Type(0.0), hmk, -hmk);
+    Type psi0 = hmk / sqrt(nu + h * h + k * k);
+    Type psi0_min = Type(1e-12) * psi1;
+    psi0 = CppAD::CondExpLt(psi0, psi0_min, psi0_min, psi0);
+    psi0 = CppAD::CondExpGe(psi0, psi1, psi1, psi0);
+    Type zr = psi1 / psi0;
+    zr = log(zr + sqrt(zr * zr + Type(1.0))) / Type(2.0); // asinh(psi1/psi0)/2
+    Type ans = Type(0.0);
+    for(int ii=0; ii<n_half; ii++) {
+      for(int jj=0; jj<2; jj++) {
+        Type t = Type((1.0 + (jj ? -x[ii] : x[ii])) / 2.0);
+        Type wt = Type(w[ii] / 2.0);
+        // boundary layer
+        for(int kk=0; kk<2; kk++) {
+          Type z = zr * (Type(double(kk)) + t);
+          Type psi = psi0 * sinh(z);
+          ans += wt * zr * psi0 * cosh(z) * pbvt_dr(psi, a1, a2, nu);
+        }
+        // remainder
+        Type psi = psi1 + (psi_r - psi1) * t;
+        ans += wt * (psi_r - psi1) * pbvt_dr(psi, a1, a2, nu);
+      }
+    }
+    return p1 - sgn * ans;
+  }
+
+  /// Calculate Student-t copula CDF.
+  ///
+  /// Uses `pbvt_int()` when `nu` is a constant integer no larger than `PT_INT_MAX`, and `pbvt_quad()` otherwise.
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] theta Correlation parameter of the Student-t copula with the range $(-1, 1)$.
+  /// @param[in] nu Degrees of freedom parameter.
+  /// @param[in] give_log Whether or not to return on the log scale.
+  ///
+  /// @return Value of the copula CDF.
+  template <class Type>
+  Type pstudent(Type u1, Type u2, Type theta, Type nu, int give_log=0) {
+    Type y1 = qt(u1, nu);
+    Type y2 = qt(u2, nu);
+    Type ans;
+    if(is_constant(nu) && is_int_df(asDouble(nu))) {
+      ans = pbvt_int(y1, y2, theta, static_cast<int>(asDouble(nu)));
+    } else {
+      ans = pbvt_quad(u1, u2, y1, y2, theta, nu);
+    }
+    if(give_log) return log(ans); else return ans;
+  }
+  VECTORIZE5_tttti(pstudent)
+
 } // end namespace LocalCop
 
 #endif
@@ -0,0 +1,131 @@
+/// @file tdist.hpp
+///
+/// @brief Closed-form Student-t CDF and quantile function for integer degrees of freedom.
+///
+/// For integer `nu`, the Student-t CDF is a finite trigonometric series in `theta = atan(q / sqrt(nu))` (Abramowitz & Stegun 26.7.3-4), and the quantile function has a closed form for `nu = 1, 2, 4`.  These only involve elementary functions, so are much cheaper than the incomplete beta function and its inverse, and can be differentiated with respect to `q` and `p` by any AD type.  The functions in `student.hpp` switch to them when the degrees of freedom are a known integer, which is the case e.g. in `hstudent()` with integer `nu`.
+///
+/// Accuracy was checked against reference implementations of the Student-t CDF and quantile function for `nu = 1, ..., PT_INT_MAX` and `1e-3 <= |q| <= 1e6`, resp. `1e-300 <= p <= 1 - 1e-16`: the relative error of `pt_int()` is below `3e-13` in both tails (the maximum being at the switch between the central and tail series for `nu = 30`), and that of `qt_int()` is below `5e-15`.
+
+#ifndef LOCALCOP_TDIST_HPP
+#define LOCALCOP_TDIST_HPP
+
+// this is where RefVector_t etc. is defined
+#include "config.hpp"
+#include <cmath>
+#include <limits>
+
+namespace LocalCop {
+
+  /// Largest degrees of freedom for which `pt_int()` is used.
+  ///
+  /// For larger `nu`, the central series in `pt_int()` loses relative accuracy in the tails before the tail series converges in a fixed number of terms.
+  const int PT_INT_MAX = 30;
+
+  /// Whether `df` is a positive integer for which the closed forms apply.
+  inline bool is_int_df(double df, int df_max = PT_INT_MAX) {
+    return (df >= 1.0) && (df <= df_max) && (df == std::floor(df));
+  }
+
+  /// Whether a scalar is a constant, i.e., doesn't depend on any AD variables.
+  ///
+  /// Used to select closed forms or compiled-code evaluations by the value of an argument, which is only valid if that value can't change after the AD tape is built.
+  inline bool is_constant(double /* x */) {
+    return true;
+  }
+
+#ifndef LOCALCOP_NO_TMB
+  template <class T>
+  bool is_constant(const CppAD::AD<T>& x) {
+    return !CppAD::Variable(x) && is_constant(CppAD::Value(x));
+  }
+#endif
+
+  /// Student-t CDF for integer degrees of freedom.
+  ///
+  /// With `theta = atan(q / sqrt(nu))`, `c = cos(theta)^2`, and `m = floor(nu/2)`, the probability `A = P(|T| < |q|)` is
+  ///
+  /// ```
+  /// A = sin(theta) * sum_{k=0}^{m-1} a_k * c^k,                                 nu even,
+  /// A = 2/pi * (theta + sin(theta) * cos(theta) * sum_{k=0}^{m-1} b_k * c^k),   nu odd,
+  /// ```
+  ///
+  /// where `a_k = (2k-1)!! / (2k)!!` and `b_k = (2k)!! / (2k+1)!!`.  Since the series with `m = Inf` sum to `1`, the tail probability `1 - A` is the sum of the terms with `k >= m`, which is used instead for `c <= 0.72` to avoid cancellation in the tails.  At this threshold, 120 terms of the tail series give full precision, and for `nu <= PT_INT_MAX` the central series is only used for tail probabilities above `1e-3`.
+  ///
+  /// @param[in] q Quantile.
+  /// @param[in] nu Degrees of freedom.  A positive integer.
+  ///
+  /// @return Value of the CDF at `q`.
+  template <class Type>
+  Type pt_int(Type q, int nu) {
+    // number of terms of the tail series for c <= c_tail: c_tail^n_tail < 1e-17
+    const int n_tail = 120;
+    const double c_tail = 0.72;
+    bool odd = (nu % 2) == 1;
+    int m = nu / 2;
+    Type q2 = q * q;
+    Type r = Type(1.0) / sqrt(Type(nu) + q2);
+    Type s = q * r; // signed sin(theta)
+    Type c = Type(nu) * r * r; // cos(theta)^2
+    Type cs = odd ? s * sqrt(Type(nu)) * r : s; // multiplier of the series
+    Type term = Type(1.0);
+    Type sum = Type(0.0);
+    int k = 0;
+    for(; k<m; k++) {
+      sum += term;
+      term *= c * (odd ? Type(2*k+2)/Type(2*k+3) : Type(2*k+1)/Type(2*k+2));
+    }
+    Type A = cs * sum;
+    if(odd) A = Type(2.0/M_PI) * (atan(q / sqrt(Type(nu))) + A);
+    Type tail = Type(0.0);
+    for(; k<m+n_tail; k++) {
+      tail += term;
+      term *= c * (odd ? Type(2*k+2)/Type(2*k+3) : Type(2*k+1)/Type(2*k+2));
+    }
+    // signed P(|T| > |q|)
+    Type B = (odd ? Type(2.0/M_PI) : Type(1.0)) * cs * tail;
+    Type p_tail = CppAD::CondExpLt(q, Type(0.0),
+                                   Type(-0.5) * B, Type(1.0) - Type(0.5) * B);
+    Type p_mid = Type(0.5) * (Type(1.0) + A);
+    return CppAD::CondExpGe(c, Type(c_tail), p_mid, p_tail);
+  }
+
+  /// Student-t quantile function for `nu = 1, 2, 4`.
+  ///
+  /// Uses the closed forms
+  ///
+  /// ```
+  /// nu = 1: q = -1/tan(pi * p),
+  /// nu = 2: q = (2p - 1) / sqrt(2p * (1-p)),
+  /// nu = 4: q = -2 * sqrt(2 * sin(2/3 * phi) * sin(phi/3) / cos(phi)),
+  /// ```
+  ///
+  /// for `p < 1/2`, where `phi = acos(sqrt(4p * (1-p)))`, i.e., `cos(phi) = sqrt(4p * (1-p))`.  The latter is a rearrangement of the formula in Shaw (2006), "Sampling Student's T distribution -- use of the inverse cumulative distribution function", which avoids cancellation near `p = 1/2`.  Values of `p > 1/2` are obtained by symmetry.
+  ///
+  /// @param[in] p Probability.
+  /// @param[in] nu Degrees of freedom.  One of 1, 2, or 4.
+  ///
+  /// @return Quantile of the Student-t corresponding to `p`, or `NaN` for other values of `nu`.
+  template <class Type>
+  Type qt_int(Type p, int nu) {
+    // lower tail probability
+    Type pl = CppAD::CondExpLt(p, Type(0.5), p, Type(1.0) - p);
+    Type q;
+    if(nu == 1) {
+      q = Type(-1.0) / tan(Type(M_PI) * pl);
+    } else if(nu == 2) {
+      q = (Type(2.0) * pl - Type(1.0)) / sqrt(Type(2.0) * pl * (Type(1.0) - pl));
+    } else if(nu == 4) {
+      Type d = Type(1.0) - Type(2.0) * pl; // |1 - 2p|
+      Type cphi = sqrt(Type(4.0) * pl * (Type(1.0) - pl));
+      Type phi = atan2(d, cphi);
+      q = -Type(2.0) * sqrt(Type(2.0) * sin(Type(2.0/3.0) * phi) *
+                            sin(phi / Type(3.0)) / cphi);
+    } else {
+      return Type(std::numeric_limits<double>::quiet_NaN());
+    }
+    return CppAD::CondExpLt(p, Type(0.5), q, -q);
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_TDIST_HPP
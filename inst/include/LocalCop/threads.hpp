@@ -0,0 +1,74 @@
+/// @file threads.hpp
+///
+/// @brief Dynamically scheduled parallel loops with `std::thread`.
+
+#ifndef LOCALCOP_THREADS_HPP
+#define LOCALCOP_THREADS_HPP
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <exception>
+#include <algorithm>
+
+namespace LocalCop {
+
+  /// Number of threads to use.
+  ///
+  /// @param[in] nthreads Requested number of threads.  If `nthreads <= 0`, uses the number of hardware threads.
+  /// @param[in] ntasks Number of tasks to run.
+  ///
+  /// @return A number of threads between 1 and `ntasks`.
+  inline int get_nthreads(int nthreads, int ntasks) {
+    if(nthreads <= 0) {
+      nthreads = std::thread::hardware_concurrency();
+    }
+    return std::max(1, std::min(nthreads, ntasks));
+  }
+
+  /// Run `fun(task, thread)` for `task = 0, ..., ntasks-1` on `nthreads` threads.
+  ///
+  /// Tasks are taken off a shared atomic counter in increasing order, such that a thread which finishes its task early immediately takes the next one.  This balances the load when the cost of each task is uneven, e.g., when the number of observations in the local likelihood varies with `x0`.
+  ///
+  /// With `nthreads = 1` everything is run on the calling thread.  Otherwise, `fun` must not call the R API, and must only write to memory which is specific to `task` or to `thread`.  The first exception thrown by `fun` is rethrown on the calling thread once all threads have finished.
+  ///
+  /// @param[in] ntasks Number of tasks.
+  /// @param[in] nthreads Number of threads.  See `get_nthreads()`.
+  /// @param[in] fun Function object with signature `void fun(int task, int thread)`.
+  template <class Fun>
+  void parallel_for(int ntasks, int nthreads, Fun&& fun) {
+    nthreads = get_nthreads(nthreads, ntasks);
+    if(nthreads == 1) {
+      for(int task=0; task<ntasks; task++) fun(task, 0);
+      return;
+    }
+    std::atomic<int> next_task(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::exception_ptr> errors(nthreads);
+    auto worker = [&](int thread) {
+      try {
+        int task;
+        while(!failed && (task = next_task++) < ntasks) {
+          fun(task, thread);
+        }
+      } catch(...) {
+        errors[thread] = std::current_exception();
+        failed = true;
+      }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(nthreads - 1);
+    for(int thread=1; thread<nthreads; thread++) {
+      pool.emplace_back(worker, thread);
+    }
+    worker(0);
+    for(auto& th : pool) th.join();
+    for(auto& err : errors) {
+      if(err) std::rethrow_exception(err);
+    }
+    return;
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_THREADS_HPP
@@ -0,0 +1,119 @@
+/// @file transform.hpp
+///
+/// @brief Marginal transformations of the copula families.
+///
+/// The copula log-densities depend on the uniform variables only through transformations which do not involve the copula parameter: normal quantiles for the Gaussian copula, Student-t quantiles and log-PDFs for the Student-t copula, `log(u)` for the Clayton copula, and `log(u)` and `log(-log(u))` for the Gumbel copula.  These are the expensive part of each evaluation, so are calculated once per dataset by `utrans()` and stored as the columns of a matrix, which is then passed to the local likelihood as data.  Rotations are applied before the transformation, such that `lpdf_eta_utrans()` only needs the family modulo 10.
+///
+/// The functions in this file take the family code as an argument, and are convenient for single evaluations.  Loops over observations should instead be instantiated with the family classes in `family.hpp`.
+
+#ifndef LOCALCOP_TRANSFORM_HPP
+#define LOCALCOP_TRANSFORM_HPP
+
+// this is where RefVector_t etc. is defined
+#include "config.hpp"
+#include "family.hpp"
+
+namespace LocalCop {
+
+  /// Function objects calling the members of the family classes.
+  namespace family_fun {
+
+    struct NTrans {
+      typedef int result_type;
+      template <template<class> class Family>
+      int operator()(FamilyTag<Family>) const {
+        return Family<double>::n_trans;
+      }
+    };
+
+    template <class Type>
+    struct Utrans {
+      typedef void result_type;
+      Type u1, u2, nu;
+      Type* v;
+      template <template<class> class Family>
+      void operator()(FamilyTag<Family>) const {
+        Family<Type>::utrans(u1, u2, nu, v);
+      }
+    };
+
+    template <class Type>
+    struct Theta {
+      typedef Type result_type;
+      Type eta;
+      template <template<class> class Family>
+      Type operator()(FamilyTag<Family>) const {
+        return Family<Type>::theta(eta);
+      }
+    };
+
+    template <class Type>
+    struct LpdfUtrans {
+      typedef Type result_type;
+      const Type* v;
+      Type eta, nu;
+      template <template<class> class Family>
+      Type operator()(FamilyTag<Family>) const {
+        return Family<Type>::lpdf_utrans(v, Family<Type>::theta(eta), nu);
+      }
+    };
+
+  } // end namespace family_fun
+
+  /// Number of marginal transformations per observation.
+  ///
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  ///
+  /// @return The number of columns of the transformation matrix.  See `utrans()`.
+  inline int utrans_size(int family) {
+    return dispatch_family(family, family_fun::NTrans());
+  }
+
+  /// Marginal transformations of a single observation.
+  ///
+  /// @param[in] u1 First uniform variable.
+  /// @param[in] u2 Second uniform variable.
+  /// @param[in] nu Second copula parameter.  Only used if `family = 2`.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  /// @param[out] v Array of length `utrans_size(family)` containing, after rotating `u1` and/or `u2`:
+  /// - Gaussian: `qnorm(u1)`, `qnorm(u2)`.
+  /// - Student-t: `y1 = qt(u1, nu)`, `y2 = qt(u2, nu)`, and `dt(y1, nu, 1) + dt(y2, nu, 1)`.
+  /// - Clayton: `log(u1)`, `log(u2)`.
+  /// - Gumbel: `log(u1)`, `log(u2)`, `log(-log(u1))`, `log(-log(u2))`.
+  /// - Frank: `u1`, `u2`.
+  template <class Type>
+  void utrans(Type u1, Type u2, Type nu, int family, Type* v) {
+    family_fun::Utrans<Type> fun = {u1, u2, nu, v};
+    dispatch_family(family, fun);
+    return;
+  }
+
+  /// Copula parameter on the original scale.
+  ///
+  /// @param[in] eta Dependence parameter on the calibration scale.  See `BiCopEta2Par()`.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  ///
+  /// @return The copula parameter `theta`, i.e., `tanh(eta)` for the Gaussian and Student-t copulas, `exp(eta)` for the Clayton copula, `1 + exp(eta)` for the Gumbel copula, and `eta` for the Frank copula.
+  template <class Type>
+  Type theta_eta(Type eta, int family) {
+    family_fun::Theta<Type> fun = {eta};
+    return dispatch_family(family, fun);
+  }
+
+  /// Copula log-density on the calibration scale in terms of the marginal transformations.
+  ///
+  /// @param[in] v Array of marginal transformations.  See `utrans()`.
+  /// @param[in] eta Dependence parameter on the calibration scale.  See `BiCopEta2Par()`.
+  /// @param[in] nu Second copula parameter.  Only used if `family = 2`.
+  /// @param[in] family Copula family.  See `ConvertPar()`.
+  ///
+  /// @return Value of the copula log-density.
+  template <class Type>
+  Type lpdf_eta_utrans(const Type* v, Type eta, Type nu, int family) {
+    family_fun::LpdfUtrans<Type> fun = {v, eta, nu};
+    return dispatch_family(family, fun);
+  }
+
+} // end namespace LocalCop
+
+#endif // LOCALCOP_TRANSFORM_HPP
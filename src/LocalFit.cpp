@@ -0,0 +1,283 @@
+/// @file LocalFit.cpp
+///
+/// @brief Native local likelihood fitting over a grid of covariate values.
+
+// [[Rcpp::depends(RcppEigen)]]
+#include <RcppEigen.h>
+#include "LocalCop/fitgrid.hpp"
+#include "LocalCop/binned.hpp"
+#include "LocalCop/predict.hpp"
+#include <vector>
+
+using namespace Rcpp;
+using namespace LocalCop;
+
+/// Marginal transformations of the copula family.
+///
+/// @param[in] u1 Vector of first uniform variables.
+/// @param[in] u2 Vector of second uniform variables.
+/// @param[in] family Copula family.
+/// @param[in] nu Second copula parameter.  Either a scalar or a vector of the same length as `u1`.
+///
+/// @return A matrix with one row per observation and `utrans_size(family)` columns.  See `utrans()`.
+// [[Rcpp::export]]
+Eigen::MatrixXd LocalLik_utrans(Eigen::Map<Eigen::VectorXd> u1,
+                                Eigen::Map<Eigen::VectorXd> u2,
+                                int family,
+                                Eigen::Map<Eigen::VectorXd> nu) {
+  int n = u1.size();
+  if(u2.size() != n || (nu.size() != 1 && nu.size() != n)) {
+    Rcpp::stop("u1 and u2 must have the same length, and nu must be of length 1 or the same length.");
+  }
+  int nv = utrans_size(family);
+  Eigen::MatrixXd ut(n, nv);
+  double v[4];
+  for(int ii=0; ii<n; ii++) {
+    utrans<double>(u1(ii), u2(ii), nu(nu.size() == 1 ? 0 : ii), family, v);
+    for(int jj=0; jj<nv; jj++) ut(ii,jj) = v[jj];
+  }
+  return ut;
+}
+
+/// Fit the local likelihood at each element of `x0`.
+///
+/// @param[in] utrans Matrix of marginal transformations of the uniform responses, as returned by `LocalLik_utrans()`.
+/// @param[in] x Matrix of covariates, with one row per observation and one column per covariate.
+/// @param[in] x0 Matrix of covariate values at which to fit the local likelihood, with one row per fit.
+/// @param[in] drop Integer vector of length `nrow(x0)` giving the (0-based) index of the observation to leave out of each fit, with negative values for none.  Can also be of length zero, in which case all observations are used in every fit.
+/// @param[in] family Copula family.
+/// @param[in] nu Second copula parameter.
+/// @param[in] degree Total degree of the local polynomial.
+/// @param[in] kernel Integer code of the kernel function.  See `kernel.hpp`.
+/// @param[in] band Vector of kernel bandwidths, of length one or one per covariate, or fraction of observations for a variable bandwidth.
+/// @param[in] band_type Integer code of the bandwidth type.  See `BandType`.
+/// @param[in] eta Matrix with `max(2, npar)` rows giving the starting value of `beta`, where `npar` is the number of local polynomial coefficients.  Either a single column used at each `x0`, or one column per element of `x0`.
+/// @param[in] warm_start,maxit,reltol,loo_steps,analytic,nthreads Control parameters.  See `GridControl`.
+/// @param[in] freq Vector of frequency weights of the rows of `utrans`, or of length zero for unit weights.
+///
+/// @details See `fit_grid()`.
+///
+/// @return A list with elements `coef`, `se`, `hessian`, `nll`, `convergence`, and `niter`.  See `GridFit`.
+// [[Rcpp::export]]
+Rcpp::List LocalFit_grid(Eigen::Map<Eigen::MatrixXd> utrans,
+                         Eigen::Map<Eigen::MatrixXd> x,
+                         Eigen::Map<Eigen::MatrixXd> x0,
+                         Rcpp::IntegerVector drop,
+                         int family, double nu, int degree,
+                         int kernel, Eigen::Map<Eigen::VectorXd> band,
+                         int band_type,
+                         Eigen::Map<Eigen::MatrixXd> eta,
+                         bool warm_start, int maxit, double reltol,
+                         int loo_steps, bool analytic, int nthreads,
+                         Eigen::Map<Eigen::VectorXd> freq) {
+  if(freq.size() != 0 && freq.size() != x.rows()) {
+    Rcpp::stop("freq must have length 0 or length(x).");
+  }
+  GridControl ctrl;
+  ctrl.warm_start = warm_start;
+  ctrl.maxit = maxit;
+  ctrl.reltol = reltol;
+  ctrl.loo_steps = loo_steps;
+  ctrl.analytic = analytic;
+  ctrl.nthreads = nthreads;
+  ctrl.band_type = static_cast<BandType>(band_type);
+  GridFit fit;
+  fit_grid(utrans, x, x0, std::vector<int>(drop.begin(), drop.end()),
+           family, nu, degree, static_cast<Kernel>(kernel), band,
+           eta, ctrl, fit, freq.size() ? freq.data() : nullptr);
+  return Rcpp::List::create(Rcpp::Named("coef") = fit.coef,
+                            Rcpp::Named("se") = fit.se,
+                            Rcpp::Named("hessian") = fit.hessian,
+                            Rcpp::Named("nll") = fit.nll,
+                            Rcpp::Named("convergence") = Rcpp::wrap(fit.convergence),
+                            Rcpp::Named("niter") = Rcpp::wrap(fit.niter));
+}
+
+/// Bin a dataset along `x`, and optionally along `(u1, u2)`.
+///
+/// @param[in] u1 Vector of first uniform variables, sorted by `x`.
+/// @param[in] u2 Vector of second uniform variables, sorted by `x`.
+/// @param[in] x Sorted vector of covariates.
+/// @param[in] family Copula family.
+/// @param[in] nu Second copula parameter.
+/// @param[in] nbin_x Number of bins along `x`.
+/// @param[in] nbin_u Number of bins along each of `u1` and `u2`, or 0 for none.
+///
+/// @details See `bin_data()`.
+///
+/// @return A list with elements `x`, `utrans`, `freq`, and `cell`, the latter of which is 0-based.  See `BinnedData`.
+// [[Rcpp::export]]
+Rcpp::List LocalFit_bin(Eigen::Map<Eigen::VectorXd> u1,
+                        Eigen::Map<Eigen::VectorXd> u2,
+                        Eigen::Map<Eigen::VectorXd> x,
+                        int family, double nu, int nbin_x, int nbin_u) {
+  BinnedData bin;
+  bin_data(u1, u2, x, family, nu, nbin_x, nbin_u, bin);
+  return Rcpp::List::create(Rcpp::Named("x") = bin.x,
+                            Rcpp::Named("utrans") = bin.utrans,
+                            Rcpp::Named("freq") = bin.freq,
+                            Rcpp::Named("cell") = Rcpp::wrap(bin.cell));
+}
+
+/// Error of binned local likelihood estimates with respect to the exact local likelihood.
+///
+/// @param[in] utrans,x,x0,drop,family,nu,degree,kernel,band See `LocalFit_grid()`, for the full dataset.
+/// @param[in] coef A matrix with 2 rows and `length(x0)` columns of binned estimates.
+/// @param[in] analytic,nthreads Control parameters.  See `GridControl`.
+///
+/// @details See `bin_error()`.
+///
+/// @return A matrix with 2 rows and `length(x0)` columns.
+// [[Rcpp::export]]
+Eigen::MatrixXd LocalFit_binerr(Eigen::Map<Eigen::MatrixXd> utrans,
+                                Eigen::Map<Eigen::VectorXd> x,
+                                Eigen::Map<Eigen::VectorXd> x0,
+                                Rcpp::IntegerVector drop,
+                                int family, double nu, int degree,
+                                int kernel, double band,
+                                Eigen::Map<Eigen::MatrixXd> coef,
+                                bool analytic, int nthreads) {
+  GridControl ctrl;
+  ctrl.analytic = analytic;
+  ctrl.nthreads = nthreads;
+  Eigen::MatrixXd err;
+  bin_error(utrans, x, x0, std::vector<int>(drop.begin(), drop.end()),
+            family, nu, degree, static_cast<Kernel>(kernel), band,
+            coef, ctrl, err);
+  return err;
+}
+
+/// Copula log-density on the calibration scale and its first two derivatives.
+///
+/// @param[in] u1 Vector of first uniform variables.
+/// @param[in] u2 Vector of second uniform variables.
+/// @param[in] eta Vector of dependence parameters on the calibration scale.
+/// @param[in] family Copula family.
+/// @param[in] nu Second copula parameter.
+/// @param[in] analytic Whether to use closed-form derivatives where available.  In this case the one-parameter families are evaluated with `lpdf_eta_batch()`.  Otherwise, see `lpdf_eta_deriv()`.
+///
+/// @return A matrix with three columns: the log-density and its first and second derivatives with respect to `eta`.
+// [[Rcpp::export]]
+Eigen::MatrixXd LocalLik_deriv(Eigen::Map<Eigen::VectorXd> u1,
+                               Eigen::Map<Eigen::VectorXd> u2,
+                               Eigen::Map<Eigen::VectorXd> eta,
+                               int family, double nu, bool analytic) {
+  int n = u1.size();
+  Eigen::MatrixXd ans(n, 3);
+  if(analytic && has_lpdf_batch(family)) {
+    Eigen::MatrixXd ut(n, utrans_size(family));
+    utrans(u1, u2, nu, family, ut);
+    lpdf_eta_batch(ut.data(), n, eta.data(), n, family,
+                   ans.col(0).data(), ans.col(1).data(), ans.col(2).data());
+    return ans;
+  }
+  for(int ii=0; ii<n; ii++) {
+    ans(ii,0) = lpdf_eta_deriv(u1(ii), u2(ii), eta(ii), nu, family,
+                               analytic, ans(ii,1), ans(ii,2));
+  }
+  return ans;
+}
+
+/// Set or query the instruction set used by the batched log-densities.
+///
+/// @param[in] level Maximum instruction set to use: 0 for scalar code, 1 for AVX2, and 2 for AVX-512.  If negative, the setting is left unchanged.
+///
+/// @return The instruction set used, i.e., the smaller of `level` and the highest one supported by the CPU.  See `SimdLevel`.
+// [[Rcpp::export]]
+int LocalCop_simd(int level) {
+  if(level >= 0) set_simd_level(level);
+  return static_cast<int>(simd_level());
+}
+
+/// Batched `exp()` or `log()` computed in place.
+///
+/// @param[in] x Vector of arguments.
+/// @param[in] log If `true`, computes `vlog()`, otherwise `vexp()`.
+///
+/// @return The vector of results, calculated with the instruction set set by `LocalCop_simd()`.  The output overwrites a copy of `x`, which is how the batched log-densities call these functions.
+// [[Rcpp::export]]
+Eigen::VectorXd LocalCop_vmath(Eigen::Map<Eigen::VectorXd> x, bool log) {
+  Eigen::VectorXd y = x;
+  int n = y.size();
+  if(log) {
+    vlog(y.data(), y.data(), n);
+  } else {
+    vexp(y.data(), y.data(), n);
+  }
+  return y;
+}
+
+/// Kernel weights of all observations at a single covariate value.
+///
+/// @param[in] x Vector of covariates.
+/// @param[in] x0 Covariate value.
+/// @param[in] band Kernel bandwidth, or fraction of observations for a variable bandwidth.
+/// @param[in] kernel Integer code of the kernel function.  See `kernel.hpp`.
+/// @param[in] band_type Integer code of the bandwidth type.  See `BandType`.
+///
+/// @details See `kernel_weights()`.
+///
+/// @return A vector of kernel weights of the same length as `x`.
+// [[Rcpp::export]]
+Eigen::VectorXd KernWeight_native(Eigen::Map<Eigen::VectorXd> x,
+                                  double x0, double band,
+                                  int kernel, int band_type) {
+  Eigen::VectorXd wgt(x.size());
+  kernel_weights(x.data(), x.size(), x0, band, static_cast<Kernel>(kernel),
+                 static_cast<BandType>(band_type), wgt.data());
+  return wgt;
+}
+
+/// Predict from a local likelihood fit at new observations.
+///
+/// @param[in] x0 Sorted vector of covariate values at which the local likelihood was fit.
+/// @param[in] beta Matrix of local coefficient estimates with `length(x0)` rows and 1 or 2 columns.
+/// @param[in] nu Second copula parameter: vector of length 1 or `length(x0)`.
+/// @param[in] family Copula family.
+/// @param[in] x Vector of new covariate values.
+/// @param[in] u1,u2 Vectors of new uniform variables.  See `GridModel::predict()`.
+/// @param[in] type Integer code of the function to evaluate.  See `PredictType`.
+/// @param[in] give_log Whether to return on the log scale.
+/// @param[in] rule How to treat values of `x` outside `range(x0)`.  See `GridModel::interp()`.
+/// @param[in] nthreads Number of threads.
+///
+/// @return A vector of the same length as `x`.
+// [[Rcpp::export]]
+Eigen::VectorXd LocalFit_predict(Eigen::Map<Eigen::VectorXd> x0,
+                                 Eigen::Map<Eigen::MatrixXd> beta,
+                                 Eigen::Map<Eigen::VectorXd> nu,
+                                 int family,
+                                 Eigen::Map<Eigen::VectorXd> x,
+                                 Eigen::Map<Eigen::VectorXd> u1,
+                                 Eigen::Map<Eigen::VectorXd> u2,
+                                 int type, bool give_log, int rule,
+                                 int nthreads) {
+  GridModel model(x0, beta, nu, family);
+  Eigen::VectorXd out(x.size());
+  model.predict(static_cast<PredictType>(type), x, u1, u2, give_log, rule,
+                nthreads, out);
+  return out;
+}
+
+/// Simulate from a local likelihood fit at new covariate values.
+///
+/// @param[in] x0,beta,nu,family Local likelihood fit.  See `LocalFit_predict()`.
+/// @param[in] x Vector of new covariate values.
+/// @param[in] n Number of draws at each element of `x`.
+/// @param[in] seed Seed of the random number streams: an integer value between 0 and `2^53`.
+/// @param[in] rule How to treat values of `x` outside `range(x0)`.  See `GridModel::interp()`.
+/// @param[in] nthreads Number of threads.
+///
+/// @return A matrix with `n * length(x)` rows and columns `u1` and `u2`.  See `GridModel::simulate()`.
+// [[Rcpp::export]]
+Eigen::MatrixXd LocalFit_sim(Eigen::Map<Eigen::VectorXd> x0,
+                             Eigen::Map<Eigen::MatrixXd> beta,
+                             Eigen::Map<Eigen::VectorXd> nu,
+                             int family,
+                             Eigen::Map<Eigen::VectorXd> x,
+                             int n, double seed, int rule, int nthreads) {
+  GridModel model(x0, beta, nu, family);
+  Eigen::MatrixXd u(n * x.size(), 2);
+  model.simulate(x, n, static_cast<uint64_t>(seed), rule, nthreads, u);
+  return u;
+}
@@ -0,0 +1,91 @@
+/// @file OnlineFit.cpp
+///
+/// @brief Online local likelihood estimation for streaming observations.
+
+// [[Rcpp::depends(RcppEigen)]]
+#include <RcppEigen.h>
+#include "LocalCop/online.hpp"
+
+using namespace Rcpp;
+using namespace LocalCop;
+
+/// Create an online local likelihood estimator.
+///
+/// @param[in] x0 Sorted vector of covariate values at which to fit the local likelihood.
+/// @param[in] family Copula family.
+/// @param[in] nu Second copula parameter.
+/// @param[in] degree Degree of the local polynomial: 0 or 1.
+/// @param[in] kernel Integer code of the kernel function.  See `kernel.hpp`.
+/// @param[in] band Kernel bandwidth.
+/// @param[in] eta Vector of length 2 giving the starting value of `beta`.
+///
+/// @return An external pointer to an `OnlineFit` object.
+// [[Rcpp::export]]
+SEXP OnlineFit_new(Eigen::Map<Eigen::VectorXd> x0,
+                   int family, double nu, int degree,
+                   int kernel, double band,
+                   Eigen::Map<Eigen::VectorXd> eta) {
+  if(eta.size() != 2) Rcpp::stop("eta must be a vector of length 2.");
+  Rcpp::XPtr<OnlineFit> ptr(new OnlineFit(x0, family, nu, degree,
+                                          static_cast<Kernel>(kernel), band,
+                                          eta), true);
+  return ptr;
+}
+
+/// Add observations to an online local likelihood estimator.
+///
+/// @param[in] ptr External pointer returned by `OnlineFit_new()`.
+/// @param[in] u1,u2,x,time See `OnlineFit::add()`.
+// [[Rcpp::export]]
+void OnlineFit_add(SEXP ptr,
+                   Eigen::Map<Eigen::VectorXd> u1,
+                   Eigen::Map<Eigen::VectorXd> u2,
+                   Eigen::Map<Eigen::VectorXd> x,
+                   Eigen::Map<Eigen::VectorXd> time) {
+  Rcpp::XPtr<OnlineFit> of(ptr);
+  of->add(u1, u2, x, time);
+  return;
+}
+
+/// Remove observations from an online local likelihood estimator.
+///
+/// @param[in] ptr External pointer returned by `OnlineFit_new()`.
+/// @param[in] time Observations which arrived before `time` are removed.
+///
+/// @return The number of observations removed.
+// [[Rcpp::export]]
+int OnlineFit_expire(SEXP ptr, double time) {
+  Rcpp::XPtr<OnlineFit> of(ptr);
+  return of->expire(time);
+}
+
+/// Refit an online local likelihood estimator.
+///
+/// @param[in] ptr External pointer returned by `OnlineFit_new()`.
+/// @param[in] maxit,nsteps,reltol,analytic,nthreads Control parameters.  See `OnlineControl`.
+/// @param[in] reset Whether to refit every grid point from scratch.
+///
+/// @details See `OnlineFit::update()`.
+///
+/// @return A list with elements `coef`, `se`, `nll`, `convergence`, `niter`, and `nlocal`, as in `LocalFit_grid()`, and `nobs` and `nfit`, the number of observations in the window and of grid points which were refit.
+// [[Rcpp::export]]
+Rcpp::List OnlineFit_update(SEXP ptr, int maxit, int nsteps, double reltol,
+                            bool analytic, int nthreads, bool reset) {
+  Rcpp::XPtr<OnlineFit> of(ptr);
+  OnlineControl ctrl;
+  ctrl.maxit = maxit;
+  ctrl.nsteps = nsteps;
+  ctrl.reltol = reltol;
+  ctrl.analytic = analytic;
+  ctrl.nthreads = nthreads;
+  if(reset) of->reset();
+  int nfit = of->update(ctrl);
+  return Rcpp::List::create(Rcpp::Named("coef") = of->coef(),
+                            Rcpp::Named("se") = of->se(),
+                            Rcpp::Named("nll") = of->nll(),
+                            Rcpp::Named("convergence") = Rcpp::wrap(of->convergence()),
+                            Rcpp::Named("niter") = Rcpp::wrap(of->niter()),
+                            Rcpp::Named("nlocal") = Rcpp::wrap(of->n_local()),
+                            Rcpp::Named("nobs") = of->n_obs(),
+                            Rcpp::Named("nfit") = nfit);
+}
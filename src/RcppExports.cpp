@@ -0,0 +1,282 @@
+// Generated by using Rcpp::compileAttributes() -> do not edit by hand
+// Generator token: 10BE3573-1514-4C36-9D1C-5A225CD40393
+
+#include <RcppEigen.h>
+#include <Rcpp.h>
+
+using namespace Rcpp;
+
+#ifdef RCPP_USE_GLOBAL_ROSTREAM
+Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
+Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
+#endif
+
+// LocalLik_utrans
+Eigen::MatrixXd LocalLik_utrans(Eigen::Map<Eigen::VectorXd> u1, Eigen::Map<Eigen::VectorXd> u2, int family, Eigen::Map<Eigen::VectorXd> nu);
+RcppExport SEXP _LocalCop_LocalLik_utrans(SEXP u1SEXP, SEXP u2SEXP, SEXP familySEXP, SEXP nuSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u1(u1SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u2(u2SEXP);
+    Rcpp::traits::input_parameter< int >::type family(familySEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type nu(nuSEXP);
+    rcpp_result_gen = Rcpp::wrap(LocalLik_utrans(u1, u2, family, nu));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// LocalFit_grid
+Rcpp::List LocalFit_grid(Eigen::Map<Eigen::MatrixXd> utrans, Eigen::Map<Eigen::MatrixXd> x, Eigen::Map<Eigen::MatrixXd> x0, Rcpp::IntegerVector drop, int family, double nu, int degree, int kernel, Eigen::Map<Eigen::VectorXd> band, int band_type, Eigen::Map<Eigen::MatrixXd> eta, bool warm_start, int maxit, double reltol, int loo_steps, bool analytic, int nthreads, Eigen::Map<Eigen::VectorXd> freq);
+RcppExport SEXP _LocalCop_LocalFit_grid(SEXP utransSEXP, SEXP xSEXP, SEXP x0SEXP, SEXP dropSEXP, SEXP familySEXP, SEXP nuSEXP, SEXP degreeSEXP, SEXP kernelSEXP, SEXP bandSEXP, SEXP band_typeSEXP, SEXP etaSEXP, SEXP warm_startSEXP, SEXP maxitSEXP, SEXP reltolSEXP, SEXP loo_stepsSEXP, SEXP analyticSEXP, SEXP nthreadsSEXP, SEXP freqSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::MatrixXd> >::type utrans(utransSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::MatrixXd> >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::MatrixXd> >::type x0(x0SEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type drop(dropSEXP);
+    Rcpp::traits::input_parameter< int >::type family(familySEXP);
+    Rcpp::traits::input_parameter< double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< int >::type degree(degreeSEXP);
+    Rcpp::traits::input_parameter< int >::type kernel(kernelSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type band(bandSEXP);
+    Rcpp::traits::input_parameter< int >::type band_type(band_typeSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::MatrixXd> >::type eta(etaSEXP);
+    Rcpp::traits::input_parameter< bool >::type warm_start(warm_startSEXP);
+    Rcpp::traits::input_parameter< int >::type maxit(maxitSEXP);
+    Rcpp::traits::input_parameter< double >::type reltol(reltolSEXP);
+    Rcpp::traits::input_parameter< int >::type loo_steps(loo_stepsSEXP);
+    Rcpp::traits::input_parameter< bool >::type analytic(analyticSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type freq(freqSEXP);
+    rcpp_result_gen = Rcpp::wrap(LocalFit_grid(utrans, x, x0, drop, family, nu, degree, kernel, band, band_type, eta, warm_start, maxit, reltol, loo_steps, analytic, nthreads, freq));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// LocalFit_bin
+Rcpp::List LocalFit_bin(Eigen::Map<Eigen::VectorXd> u1, Eigen::Map<Eigen::VectorXd> u2, Eigen::Map<Eigen::VectorXd> x, int family, double nu, int nbin_x, int nbin_u);
+RcppExport SEXP _LocalCop_LocalFit_bin(SEXP u1SEXP, SEXP u2SEXP, SEXP xSEXP, SEXP familySEXP, SEXP nuSEXP, SEXP nbin_xSEXP, SEXP nbin_uSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u1(u1SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u2(u2SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type family(familySEXP);
+    Rcpp::traits::input_parameter< double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< int >::type nbin_x(nbin_xSEXP);
+    Rcpp::traits::input_parameter< int >::type nbin_u(nbin_uSEXP);
+    rcpp_result_gen = Rcpp::wrap(LocalFit_bin(u1, u2, x, family, nu, nbin_x, nbin_u));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// LocalFit_binerr
+Eigen::MatrixXd LocalFit_binerr(Eigen::Map<Eigen::MatrixXd> utrans, Eigen::Map<Eigen::VectorXd> x, Eigen::Map<Eigen::VectorXd> x0, Rcpp::IntegerVector drop, int family, double nu, int degree, int kernel, double band, Eigen::Map<Eigen::MatrixXd> coef, bool analytic, int nthreads);
+RcppExport SEXP _LocalCop_LocalFit_binerr(SEXP utransSEXP, SEXP xSEXP, SEXP x0SEXP, SEXP dropSEXP, SEXP familySEXP, SEXP nuSEXP, SEXP degreeSEXP, SEXP kernelSEXP, SEXP bandSEXP, SEXP coefSEXP, SEXP analyticSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::MatrixXd> >::type utrans(utransSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x0(x0SEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type drop(dropSEXP);
+    Rcpp::traits::input_parameter< int >::type family(familySEXP);
+    Rcpp::traits::input_parameter< double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< int >::type degree(degreeSEXP);
+    Rcpp::traits::input_parameter< int >::type kernel(kernelSEXP);
+    Rcpp::traits::input_parameter< double >::type band(bandSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::MatrixXd> >::type coef(coefSEXP);
+    Rcpp::traits::input_parameter< bool >::type analytic(analyticSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(LocalFit_binerr(utrans, x, x0, drop, family, nu, degree, kernel, band, coef, analytic, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// LocalLik_deriv
+Eigen::MatrixXd LocalLik_deriv(Eigen::Map<Eigen::VectorXd> u1, Eigen::Map<Eigen::VectorXd> u2, Eigen::Map<Eigen::VectorXd> eta, int family, double nu, bool analytic);
+RcppExport SEXP _LocalCop_LocalLik_deriv(SEXP u1SEXP, SEXP u2SEXP, SEXP etaSEXP, SEXP familySEXP, SEXP nuSEXP, SEXP analyticSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u1(u1SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u2(u2SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type eta(etaSEXP);
+    Rcpp::traits::input_parameter< int >::type family(familySEXP);
+    Rcpp::traits::input_parameter< double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< bool >::type analytic(analyticSEXP);
+    rcpp_result_gen = Rcpp::wrap(LocalLik_deriv(u1, u2, eta, family, nu, analytic));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// LocalCop_simd
+int LocalCop_simd(int level);
+RcppExport SEXP _LocalCop_LocalCop_simd(SEXP levelSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type level(levelSEXP);
+    rcpp_result_gen = Rcpp::wrap(LocalCop_simd(level));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// LocalCop_vmath
+Eigen::VectorXd LocalCop_vmath(Eigen::Map<Eigen::VectorXd> x, bool log);
+RcppExport SEXP _LocalCop_LocalCop_vmath(SEXP xSEXP, SEXP logSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x(xSEXP);
+    Rcpp::traits::input_parameter< bool >::type log(logSEXP);
+    rcpp_result_gen = Rcpp::wrap(LocalCop_vmath(x, log));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// KernWeight_native
+Eigen::VectorXd KernWeight_native(Eigen::Map<Eigen::VectorXd> x, double x0, double band, int kernel, int band_type);
+RcppExport SEXP _LocalCop_KernWeight_native(SEXP xSEXP, SEXP x0SEXP, SEXP bandSEXP, SEXP kernelSEXP, SEXP band_typeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x(xSEXP);
+    Rcpp::traits::input_parameter< double >::type x0(x0SEXP);
+    Rcpp::traits::input_parameter< double >::type band(bandSEXP);
+    Rcpp::traits::input_parameter< int >::type kernel(kernelSEXP);
+    Rcpp::traits::input_parameter< int >::type band_type(band_typeSEXP);
+    rcpp_result_gen = Rcpp::wrap(KernWeight_native(x, x0, band, kernel, band_type));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// LocalFit_predict
+Eigen::VectorXd LocalFit_predict(Eigen::Map<Eigen::VectorXd> x0, Eigen::Map<Eigen::MatrixXd> beta, Eigen::Map<Eigen::VectorXd> nu, int family, Eigen::Map<Eigen::VectorXd> x, Eigen::Map<Eigen::VectorXd> u1, Eigen::Map<Eigen::VectorXd> u2, int type, bool give_log, int rule, int nthreads);
+RcppExport SEXP _LocalCop_LocalFit_predict(SEXP x0SEXP, SEXP betaSEXP, SEXP nuSEXP, SEXP familySEXP, SEXP xSEXP, SEXP u1SEXP, SEXP u2SEXP, SEXP typeSEXP, SEXP give_logSEXP, SEXP ruleSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x0(x0SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::MatrixXd> >::type beta(betaSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< int >::type family(familySEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u1(u1SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u2(u2SEXP);
+    Rcpp::traits::input_parameter< int >::type type(typeSEXP);
+    Rcpp::traits::input_parameter< bool >::type give_log(give_logSEXP);
+    Rcpp::traits::input_parameter< int >::type rule(ruleSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(LocalFit_predict(x0, beta, nu, family, x, u1, u2, type, give_log, rule, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// LocalFit_sim
+Eigen::MatrixXd LocalFit_sim(Eigen::Map<Eigen::VectorXd> x0, Eigen::Map<Eigen::MatrixXd> beta, Eigen::Map<Eigen::VectorXd> nu, int family, Eigen::Map<Eigen::VectorXd> x, int n, double seed, int rule, int nthreads);
+RcppExport SEXP _LocalCop_LocalFit_sim(SEXP x0SEXP, SEXP betaSEXP, SEXP nuSEXP, SEXP familySEXP, SEXP xSEXP, SEXP nSEXP, SEXP seedSEXP, SEXP ruleSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x0(x0SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::MatrixXd> >::type beta(betaSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< int >::type family(familySEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< double >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type rule(ruleSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(LocalFit_sim(x0, beta, nu, family, x, n, seed, rule, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// OnlineFit_new
+SEXP OnlineFit_new(Eigen::Map<Eigen::VectorXd> x0, int family, double nu, int degree, int kernel, double band, Eigen::Map<Eigen::VectorXd> eta);
+RcppExport SEXP _LocalCop_OnlineFit_new(SEXP x0SEXP, SEXP familySEXP, SEXP nuSEXP, SEXP degreeSEXP, SEXP kernelSEXP, SEXP bandSEXP, SEXP etaSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x0(x0SEXP);
+    Rcpp::traits::input_parameter< int >::type family(familySEXP);
+    Rcpp::traits::input_parameter< double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< int >::type degree(degreeSEXP);
+    Rcpp::traits::input_parameter< int >::type kernel(kernelSEXP);
+    Rcpp::traits::input_parameter< double >::type band(bandSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type eta(etaSEXP);
+    rcpp_result_gen = Rcpp::wrap(OnlineFit_new(x0, family, nu, degree, kernel, band, eta));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// OnlineFit_add
+void OnlineFit_add(SEXP ptr, Eigen::Map<Eigen::VectorXd> u1, Eigen::Map<Eigen::VectorXd> u2, Eigen::Map<Eigen::VectorXd> x, Eigen::Map<Eigen::VectorXd> time);
+RcppExport SEXP _LocalCop_OnlineFit_add(SEXP ptrSEXP, SEXP u1SEXP, SEXP u2SEXP, SEXP xSEXP, SEXP timeSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type ptr(ptrSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u1(u1SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type u2(u2SEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Eigen::Map<Eigen::VectorXd> >::type time(timeSEXP);
+    OnlineFit_add(ptr, u1, u2, x, time);
+    return R_NilValue;
+END_RCPP
+}
+
+// OnlineFit_expire
+int OnlineFit_expire(SEXP ptr, double time);
+RcppExport SEXP _LocalCop_OnlineFit_expire(SEXP ptrSEXP, SEXP timeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type ptr(ptrSEXP);
+    Rcpp::traits::input_parameter< double >::type time(timeSEXP);
+    rcpp_result_gen = Rcpp::wrap(OnlineFit_expire(ptr, time));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// OnlineFit_update
+Rcpp::List OnlineFit_update(SEXP ptr, int maxit, int nsteps, double reltol, bool analytic, int nthreads, bool reset);
+RcppExport SEXP _LocalCop_OnlineFit_update(SEXP ptrSEXP, SEXP maxitSEXP, SEXP nstepsSEXP, SEXP reltolSEXP, SEXP analyticSEXP, SEXP nthreadsSEXP, SEXP resetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type ptr(ptrSEXP);
+    Rcpp::traits::input_parameter< int >::type maxit(maxitSEXP);
+    Rcpp::traits::input_parameter< int >::type nsteps(nstepsSEXP);
+    Rcpp::traits::input_parameter< double >::type reltol(reltolSEXP);
+    Rcpp::traits::input_parameter< bool >::type analytic(analyticSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type reset(resetSEXP);
+    rcpp_result_gen = Rcpp::wrap(OnlineFit_update(ptr, maxit, nsteps, reltol, analytic, nthreads, reset));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+static const R_CallMethodDef CallEntries[] = {
+    {"_LocalCop_LocalLik_utrans", (DL_FUNC) &_LocalCop_LocalLik_utrans, 4},
+    {"_LocalCop_LocalFit_grid", (DL_FUNC) &_LocalCop_LocalFit_grid, 18},
+    {"_LocalCop_LocalFit_bin", (DL_FUNC) &_LocalCop_LocalFit_bin, 7},
+    {"_LocalCop_LocalFit_binerr", (DL_FUNC) &_LocalCop_LocalFit_binerr, 12},
+    {"_LocalCop_LocalLik_deriv", (DL_FUNC) &_LocalCop_LocalLik_deriv, 6},
+    {"_LocalCop_LocalCop_simd", (DL_FUNC) &_LocalCop_LocalCop_simd, 1},
+    {"_LocalCop_LocalCop_vmath", (DL_FUNC) &_LocalCop_LocalCop_vmath, 2},
+    {"_LocalCop_KernWeight_native", (DL_FUNC) &_LocalCop_KernWeight_native, 5},
+    {"_LocalCop_LocalFit_predict", (DL_FUNC) &_LocalCop_LocalFit_predict, 11},
+    {"_LocalCop_LocalFit_sim", (DL_FUNC) &_LocalCop_LocalFit_sim, 9},
+    {"_LocalCop_OnlineFit_new", (DL_FUNC) &_LocalCop_OnlineFit_new, 7},
+    {"_LocalCop_OnlineFit_add", (DL_FUNC) &_LocalCop_OnlineFit_add, 5},
+    {"_LocalCop_OnlineFit_expire", (DL_FUNC) &_LocalCop_OnlineFit_expire, 2},
+    {"_LocalCop_OnlineFit_update", (DL_FUNC) &_LocalCop_OnlineFit_update, 7},
+    {NULL, NULL, 0}
+};
+
+RcppExport void R_init_LocalCop(DllInfo *dll) {
+    R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
+    R_useDynamicSymbols(dll, FALSE);
+}
@@ -3,20 +3,27 @@
 #define TMB_LIB_INIT R_init_LocalCop_TMBExports
 #include <TMB.hpp>
 #include "dclayton.hpp"
+#include "dcopula.hpp"
 #include "dfrank.hpp"
 #include "dgaussian.hpp"
 #include "dgumbel.hpp"
 #include "dstudent.hpp"
 #include "hclayton.hpp"
+#include "hcopula.hpp"
 #include "hfrank.hpp"
 #include "hgaussian.hpp"
 #include "hgumbel.hpp"
 #include "hstudent.hpp"
-#include "integral_function_test.hpp"
 #include "LocalLikelihood.hpp"
+#include "LocalLikelihoodCens.hpp"
+#include "LocalLikelihoodStudent.hpp"
+#include "LocalLikelihoodUpdate.hpp"
 #include "pclayton.hpp"
+#include "pcopula.hpp"
 #include "pfrank.hpp"
+#include "pgaussian.hpp"
 #include "pgumbel.hpp"
+#include "pstudent.hpp"
 #include "pt.hpp"
 #include "qt.hpp"
 
@@ -25,6 +32,8 @@ Type objective_function<Type>::operator() () {
   DATA_STRING(model);
   if(model == "dclayton") {
     return dclayton(this);
+  } else if(model == "dcopula") {
+    return dcopula(this);
   } else if(model == "dfrank") {
     return dfrank(this);
   } else if(model == "dgaussian") {
@@ -35,6 +44,8 @@ Type objective_function<Type>::operator() () {
     return dstudent(this);
   } else if(model == "hclayton") {
     return hclayton(this);
+  } else if(model == "hcopula") {
+    return hcopula(this);
   } else if(model == "hfrank") {
     return hfrank(this);
   } else if(model == "hgaussian") {
@@ -43,16 +54,26 @@ Type objective_function<Type>::operator() () {
     return hgumbel(this);
   } else if(model == "hstudent") {
     return hstudent(this);
-  } else if(model == "integral_function_test") {
-    return integral_function_test(this);
   } else if(model == "LocalLikelihood") {
     return LocalLikelihood(this);
+  } else if(model == "LocalLikelihoodCens") {
+    return LocalLikelihoodCens(this);
+  } else if(model == "LocalLikelihoodStudent") {
+    return LocalLikelihoodStudent(this);
+  } else if(model == "LocalLikelihoodUpdate") {
+    return LocalLikelihoodUpdate(this);
   } else if(model == "pclayton") {
     return pclayton(this);
+  } else if(model == "pcopula") {
+    return pcopula(this);
   } else if(model == "pfrank") {
     return pfrank(this);
+  } else if(model == "pgaussian") {
+    return pgaussian(this);
   } else if(model == "pgumbel") {
     return pgumbel(this);
+  } else if(model == "pstudent") {
+    return pstudent(this);
   } else if(model == "pt") {
     return pt(this);
   } else if(model == "qt") {
@@ -0,0 +1,40 @@
+/// @file LocalLikelihoodCens.hpp
+///
+/// @brief Local Likelihood with censored responses.
+///
+/// The observations must be sorted by censoring status: uncensored, first censored, second censored, both censored.  See `LocalCop::nll()`.
+
+#include "LocalCop/nll.hpp"
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR obj
+
+template<class Type>
+Type LocalLikelihoodCens(objective_function<Type> *obj) {
+  DATA_VECTOR(u1); // first response on the uniform scale
+  DATA_VECTOR(u2); // second response on the uniform scale
+  DATA_VECTOR(wgt); // weights
+  DATA_MATRIX(X); // design matrix of the local polynomial in x - x0
+  DATA_IVECTOR(status_start); // 0-based start of each censoring status
+  DATA_IVECTOR(status_length); // number of observations of each status
+  DATA_INTEGER(family); // copula family.  See ConvertPar().
+  PARAMETER_VECTOR(beta); // dependence parameter: eta = X * beta
+  DATA_SCALAR(nu); // other parameter for family 2.
+  if(!LocalCop::valid_family(family) ||
+     (status_start.size() != 4) || (status_length.size() != 4)) {
+    Rf_error("Unknown copula family or wrong censoring status format.");
+  }
+  if(!LocalCop::has_pcopula(family) && (status_length[3] > 0)) {
+    Rf_error("Copula family does not support both responses censored.");
+  }
+  std::vector<int> start(4), length(4);
+  for(int j=0; j<4; j++) {
+    start[j] = status_start[j];
+    length[j] = status_length[j];
+  }
+  return LocalCop::nll<Type>(u1.matrix(), u2.matrix(), wgt.matrix(),
+                             X, beta.matrix(), start, length, family, nu);
+}
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR this
@@ -0,0 +1,29 @@
+/// @file LocalLikelihoodStudent.hpp
+///
+/// @brief Local likelihood of the Student-t copula with locally estimated degrees of freedom.
+///
+/// Both `eta` and `log(nu - 2)` are local polynomials in `xc`.  The Student-t quantiles of the responses at the current value of `nu` are passed as data in `ycache`, which is refreshed from R whenever `gamma` changes.  See `loclik_student_nll()`.  As for the `LocalLikelihoodUpdate` model, all data vectors can be replaced without retaping.
+
+#include "LocalCop/loclik.hpp"
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR obj
+
+template<class Type>
+Type LocalLikelihoodStudent(objective_function<Type> *obj) {
+  DATA_MATRIX(u); // uniform responses
+  DATA_MATRIX(ycache); // Student-t quantiles of u at the current nu
+  DATA_VECTOR(wgt); // weights
+  DATA_VECTOR(xc); // centered covariates, i.e., X - x
+  PARAMETER_VECTOR(beta); // dependence parameter: eta = beta[0] + beta[1] * xc
+  PARAMETER_VECTOR(gamma); // degrees of freedom: log(nu-2) = gamma[0] + gamma[1] * xc
+  // these can change without retaping
+  DATA_UPDATE(u);
+  DATA_UPDATE(ycache);
+  DATA_UPDATE(wgt);
+  DATA_UPDATE(xc);
+  return LocalCop::loclik_student_nll(u, ycache, wgt, xc, beta, gamma);
+}
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR this
@@ -0,0 +1,29 @@
+/// @file LocalLikelihoodUpdate.hpp
+///
+/// @brief Local Likelihood with data that can be updated without retaping.
+///
+/// Same as the `LocalLikelihood` model, except that the data vectors are marked with `DATA_UPDATE()`.  This means that the AD tape is built once for a given family, degree, and number of observations `nobs`, after which the marginal transformations of the responses, weights, and design matrix can be replaced from R via `obj$env$data` for each new value of `x0`.  Unused observations are padded with zero weight.
+
+#include "LocalCop/loclik.hpp"
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR obj
+
+template<class Type>
+Type LocalLikelihoodUpdate(objective_function<Type> *obj) {
+  DATA_MATRIX(utrans); // marginal transformations of the responses
+  DATA_VECTOR(wgt); // weights
+  DATA_MATRIX(X); // design matrix of the local polynomial in x - x0
+  DATA_INTEGER(family); // copula family: 1-5.
+  PARAMETER_VECTOR(beta); // dependence parameter: eta = X * beta
+  DATA_VECTOR(nu); // other parameter for family 2.
+  // these can change without retaping
+  DATA_UPDATE(utrans);
+  DATA_UPDATE(wgt);
+  DATA_UPDATE(X);
+  DATA_UPDATE(nu);
+  return LocalCop::loclik_nll(utrans, wgt, X, family, beta, nu);
+}
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR this
@@ -0,0 +1,30 @@
+/// @file dcopula.hpp
+///
+/// @brief Copula PDF of any supported family, including the rotated families.
+
+#include "LocalCop/copula.hpp"
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR obj
+
+template <class Type>
+Type dcopula(objective_function<Type> *obj) {
+  // R inputs
+  DATA_VECTOR(u1);
+  DATA_VECTOR(u2);
+  DATA_VECTOR(weights);
+  DATA_INTEGER(family); // copula family.  See ConvertPar().
+  PARAMETER_VECTOR(theta); // copula parameter, as in VineCopula
+  DATA_VECTOR(nu); // other parameter for family 2.
+  if(!LocalCop::valid_family(family)) Rf_error("Unknown copula family.");
+  // output
+  vector<Type> lpdf = LocalCop::copula_fun<Type>(
+    LocalCop::COP_PDF,
+    u1.matrix(), u2.matrix(), theta.matrix(), nu.matrix(), family, 1
+  ).array();
+  lpdf.array() *= weights.array();
+  return -lpdf.sum();
+}
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR this
@@ -0,0 +1,31 @@
+/// @file hcopula.hpp
+///
+/// @brief Copula h-function of any supported family, including the rotated families.
+
+#include "LocalCop/copula.hpp"
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR obj
+
+template <class Type>
+Type hcopula(objective_function<Type> *obj) {
+  // R inputs
+  DATA_VECTOR(u1);
+  DATA_VECTOR(u2);
+  DATA_VECTOR(weights);
+  DATA_INTEGER(family); // copula family.  See ConvertPar().
+  DATA_INTEGER(which); // 1: dC/du1, 2: dC/du2
+  PARAMETER_VECTOR(theta); // copula parameter, as in VineCopula
+  DATA_VECTOR(nu); // other parameter for family 2.
+  if(!LocalCop::valid_family(family)) Rf_error("Unknown copula family.");
+  // output
+  vector<Type> lpart = LocalCop::copula_fun<Type>(
+    which == 2 ? LocalCop::COP_HFUN2 : LocalCop::COP_HFUN,
+    u1.matrix(), u2.matrix(), theta.matrix(), nu.matrix(), family, 1
+  ).array();
+  lpart.array() *= weights.array();
+  return -lpart.sum();
+}
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR this
@@ -0,0 +1,32 @@
+/// @file pcopula.hpp
+///
+/// @brief Copula CDF of any supported family, including the rotated families.
+
+#include "LocalCop/copula.hpp"
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR obj
+
+template <class Type>
+Type pcopula(objective_function<Type> *obj) {
+  // R inputs
+  DATA_VECTOR(u1);
+  DATA_VECTOR(u2);
+  DATA_VECTOR(weights);
+  DATA_INTEGER(family); // copula family.  See ConvertPar().
+  PARAMETER_VECTOR(theta); // copula parameter, as in VineCopula
+  DATA_VECTOR(nu); // other parameter for family 2.
+  if(!LocalCop::valid_family(family) || !LocalCop::has_pcopula(family)) {
+    Rf_error("Unknown copula family or copula CDF not available.");
+  }
+  // output
+  vector<Type> lcdf = LocalCop::copula_fun<Type>(
+    LocalCop::COP_CDF,
+    u1.matrix(), u2.matrix(), theta.matrix(), nu.matrix(), family, 1
+  ).array();
+  lcdf.array() *= weights.array();
+  return -lcdf.sum();
+}
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR this
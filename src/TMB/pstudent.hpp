@@ -0,0 +1,21 @@
+#include "LocalCop/student.hpp"
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR obj
+
+template <class Type>
+Type pstudent(objective_function<Type> *obj) {
+  // R inputs
+  DATA_VECTOR(u1);
+  DATA_VECTOR(u2);
+  DATA_VECTOR(weights);
+  DATA_VECTOR(nu); // data, such that integer nu uses the closed form
+  PARAMETER_VECTOR(theta);
+  // output
+  vector<Type> lcdf = LocalCop::pstudent(u1, u2, theta, nu, 1);
+  lcdf.array() *= weights.array();
+  return -lcdf.sum();
+}
+
+#undef TMB_OBJECTIVE_PTR
+#define TMB_OBJECTIVE_PTR this